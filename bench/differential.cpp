@@ -0,0 +1,148 @@
+#include "differential.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Routes random venue-shaped books with PURE_GREEDY and HYBRID, compares both with the exhaustive
+// reference and saves minimized HYBRID divergences as test data.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+struct AlgorithmStats
+{
+    size_t divergent = 0;
+    Price total_cost_gap = 0.0;
+    Price max_cost_gap = 0.0;
+    Volume total_fulfillment_gap = 0.0;
+    Volume max_fulfillment_gap = 0.0;
+    std::vector<double> latencies_us;
+
+    void add(const DifferentialResult& result, RoutingAlgorithm algorithm)
+    {
+        if (diverges(result, algorithm)) ++divergent;
+        // Cost gaps are only comparable between plans of the same volume
+        Volume fulfillment_gap = get_fulfillment_gap(result, algorithm);
+        if (std::abs(fulfillment_gap) <= 1e-6)
+        {
+            total_cost_gap += get_cost_gap(result, algorithm);
+            max_cost_gap = std::max(max_cost_gap, get_cost_gap(result, algorithm));
+        }
+        total_fulfillment_gap += fulfillment_gap;
+        max_fulfillment_gap = std::max(max_fulfillment_gap, fulfillment_gap);
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(result.get(algorithm).latency).count());
+    }
+};
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void print_row(const std::string& name, size_t cases, const AlgorithmStats& stats)
+{
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(10) << stats.divergent
+              << std::setw(14) << std::setprecision(6) << stats.total_cost_gap / static_cast<double>(cases)
+              << std::setw(14) << stats.max_cost_gap
+              << std::setw(14) << stats.total_fulfillment_gap / static_cast<double>(cases)
+              << std::setw(14) << stats.max_fulfillment_gap
+              << std::setw(10) << std::setprecision(2) << percentile(stats.latencies_us, 0.5)
+              << std::setw(10) << percentile(stats.latencies_us, 0.99) << std::endl;
+}
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--cases N] [--seed S] [--max-levels N] [--save DIR] [--max-saved N] [--no-save]" << std::endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t cases = 10000;
+    unsigned seed = 1;
+    size_t max_saved = 5;
+    fs::path save_dir = fs::path(__FILE__).parent_path().parent_path() / "tests/testdata/differential";
+    bool save = true;
+    DifferentialShape shape = default_differential_shape();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-save")
+        {
+            save = false;
+        }
+        else if (i + 1 < argc && arg == "--cases")
+        {
+            cases = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (i + 1 < argc && arg == "--seed")
+        {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (i + 1 < argc && arg == "--max-levels")
+        {
+            shape.max_levels = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (i + 1 < argc && arg == "--save")
+        {
+            save_dir = argv[++i];
+        }
+        else if (i + 1 < argc && arg == "--max-saved")
+        {
+            max_saved = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    AlgorithmStats greedy, hybrid, reference;
+    size_t hybrid_worse_than_greedy = 0;
+    size_t saved = 0;
+    for (size_t i = 0; i < cases; ++i)
+    {
+        DifferentialCase test_case = generate_case(shape, rng);
+        DifferentialResult result = run_differential(test_case);
+        greedy.add(result, RoutingAlgorithm::PURE_GREEDY);
+        hybrid.add(result, RoutingAlgorithm::HYBRID);
+        reference.latencies_us.push_back(std::chrono::duration<double, std::micro>(result.reference.latency).count());
+
+        Volume volume_delta = result.greedy.volume - result.hybrid.volume;
+        if (volume_delta > 1e-6 || (std::abs(volume_delta) <= 1e-6 && result.hybrid.cost > result.greedy.cost + 1e-6))
+        {
+            ++hybrid_worse_than_greedy;
+        }
+
+        if (save && saved < max_saved && diverges(result, RoutingAlgorithm::HYBRID))
+        {
+            DifferentialCase minimized = minimize_case(test_case, RoutingAlgorithm::HYBRID);
+            fs::path directory = save_dir / ("seed" + std::to_string(seed) + "_case" + std::to_string(i));
+            save_case(minimized, directory.string());
+            std::cerr << "Saved minimized HYBRID divergence to " << directory.string() << std::endl;
+            ++saved;
+        }
+    }
+
+    std::cout << std::fixed << cases << " cases, seed " << seed << std::endl;
+    std::cout << "Algorithm  Divergent  MeanCostGap   MaxCostGap    MeanFillGap   MaxFillGap    p50 us    p99 us" << std::endl;
+    print_row("GREEDY", cases, greedy);
+    print_row("HYBRID", cases, hybrid);
+    std::cout << std::left << std::setw(10) << "REFERENCE" << std::right << std::setw(66) << ""
+              << std::setw(10) << std::setprecision(2) << percentile(reference.latencies_us, 0.5)
+              << std::setw(10) << percentile(reference.latencies_us, 0.99) << std::endl;
+    std::cout << "HYBRID worse than GREEDY: " << hybrid_worse_than_greedy << std::endl;
+    return hybrid.divergent == 0 ? 0 : 2;
+}
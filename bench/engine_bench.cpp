@@ -0,0 +1,82 @@
+#include "routingengine.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Synthetic multi-symbol load: every symbol gets three venues with the shape of the sample books,
+// orders and quotes are spread round-robin across symbols, and throughput is measured per shard count.
+
+namespace
+{
+constexpr size_t SYMBOL_COUNT = 256;
+constexpr size_t LEVELS_PER_SIDE = 200;
+constexpr size_t REQUESTS = 20000;
+
+void load_symbols(SymbolRegistry& registry)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> volume(0.01, 2.0);
+    const VenueConfig venues[] = {{"Binance", 0.001, 0.1}, {"KuCoin", 0.0005, 0.15}, {"OKX", 0.0002, 0.2}};
+
+    for (size_t s = 0; s < SYMBOL_COUNT; ++s) 
+    {
+        SymbolId id = registry.register_symbol("SYM" + std::to_string(s));
+        Price mid = 100.0 + static_cast<double>(s);
+        for (const VenueConfig& venue : venues) 
+        {
+            auto book = registry.add_venue(id, venue);
+            for (size_t level = 1; level <= LEVELS_PER_SIDE; ++level) 
+            {
+                book->add_bid(mid - 0.01 * static_cast<double>(level), volume(rng));
+                book->add_ask(mid + 0.01 * static_cast<double>(level), volume(rng));
+            }
+        }
+    }
+}
+
+double run(size_t shard_count)
+{
+    SymbolRegistry registry;
+    load_symbols(registry);
+    RoutingEngine engine(registry, shard_count);
+
+    std::vector<std::future<ExecutionPlan>> results;
+    results.reserve(REQUESTS);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < REQUESTS; ++i) 
+    {
+        SymbolId id = static_cast<SymbolId>(i % SYMBOL_COUNT);
+        OrderSide side = (i % 2 == 0) ? OrderSide::BUY : OrderSide::SELL;
+        if (i % 4 == 0) 
+        {
+            results.push_back(engine.submit_order(id, 0.35, side));
+        } 
+        else 
+        {
+            results.push_back(engine.submit_quote(id, 2.5, side));
+        }
+    }
+    for (auto& result : results) 
+    {
+        result.get();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(REQUESTS) / seconds;
+}
+}
+
+int main()
+{
+    size_t max_shards = std::max(1u, std::thread::hardware_concurrency());
+    double baseline = 0.0;
+    std::cout << "Shards  Requests/s  Speedup" << std::endl;
+    for (size_t shards = 1; shards <= max_shards; shards *= 2) 
+    {
+        double throughput = run(shards);
+        if (shards == 1) baseline = throughput;
+        std::cout << std::setw(6) << shards << "  " << std::setw(10) << std::fixed << std::setprecision(0) << throughput
+                  << "  " << std::setprecision(2) << throughput / baseline << "x" << std::endl;
+    }
+}
@@ -0,0 +1,133 @@
+#include "routingclient.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Pipelined load generator for a running `smartorderrouter --serve ...`: keeps `pipeline` requests in
+// flight on one connection and reports round-trip latency percentiles.
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " (--unix PATH | --tcp PORT) [--requests N] [--pipeline DEPTH]"
+              << " [--type quote|distribute|liquidity] [--max-size SIZE]\n";
+}
+
+double percentile(const std::vector<double>& sorted_values, double fraction)
+{
+    if (sorted_values.empty()) return 0.0;
+    return sorted_values[static_cast<size_t>(fraction * static_cast<double>(sorted_values.size() - 1) + 0.5)];
+}
+}
+
+int main(int argc, char* argv[])
+{
+    std::string unix_path;
+    int tcp_port = -1;
+    size_t requests = 100000;
+    size_t pipeline = 32;
+    std::string type = "quote";
+    double max_size = 0.5;
+
+    for (int i = 1; i + 1 < argc; i += 2) 
+    {
+        std::string option = argv[i];
+        if (option == "--unix") unix_path = argv[i + 1];
+        else if (option == "--tcp") tcp_port = std::atoi(argv[i + 1]);
+        else if (option == "--requests") requests = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (option == "--pipeline") pipeline = std::max<size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        else if (option == "--type") type = argv[i + 1];
+        else if (option == "--max-size") max_size = std::atof(argv[i + 1]);
+        else 
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((unix_path.empty() == (tcp_port < 0)) || (type != "quote" && type != "distribute" && type != "liquidity") ||
+        argc % 2 == 0) 
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RoutingClient client;
+    try 
+    {
+        if (!unix_path.empty()) client.connect_unix(unix_path);
+        else client.connect_tcp(static_cast<uint16_t>(tcp_port));
+    } 
+    catch (const std::exception& e) 
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> size(0.01, max_size);
+    WireRequestType request_type = (type == "distribute") ? WireRequestType::DISTRIBUTE : WireRequestType::QUOTE;
+
+    std::vector<Clock::time_point> sent_at(requests);
+    std::vector<double> latencies_us;
+    latencies_us.reserve(requests);
+    size_t sent = 0;
+    size_t errors = 0;
+    std::string frames;
+
+    auto start = Clock::now();
+    auto refill = [&]() 
+    {
+        frames.clear();
+        Clock::time_point now = Clock::now();
+        while (sent < requests && sent - latencies_us.size() - errors < pipeline) 
+        {
+            OrderSide side = (sent % 2 == 0) ? OrderSide::BUY : OrderSide::SELL;
+            uint32_t request_id = static_cast<uint32_t>(sent);
+            if (type == "liquidity") encode_liquidity_request(frames, request_id, side);
+            else encode_order_request(frames, request_id, request_type, {size(rng), side, RoutingAlgorithm::HYBRID});
+            sent_at[sent++] = now;
+        }
+        if (!frames.empty()) client.send(frames);
+    };
+
+    refill();
+    WireHeader header;
+    std::string payload;
+    while (latencies_us.size() + errors < requests) 
+    {
+        if (!client.receive(header, payload)) 
+        {
+            std::cerr << "Server closed the connection\n";
+            return 1;
+        }
+        if (header.code != static_cast<uint8_t>(WireStatus::OK) || header.request_id >= requests) 
+        {
+            ++errors;
+        }
+        else 
+        {
+            latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent_at[header.request_id]).count());
+        }
+        refill();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    std::cout << std::fixed << std::setprecision(2)
+              << "Requests: " << requests << " (" << type << "), Pipeline: " << pipeline << ", Errors: " << errors << "\n"
+              << "Throughput: " << std::setprecision(0) << static_cast<double>(requests) / elapsed << " req/s\n"
+              << std::setprecision(2)
+              << "Round trip (us): p50 " << percentile(latencies_us, 0.50)
+              << ", p99 " << percentile(latencies_us, 0.99)
+              << ", max " << (latencies_us.empty() ? 0.0 : latencies_us.back()) << "\n";
+    return errors == 0 ? 0 : 2;
+}
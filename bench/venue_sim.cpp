@@ -0,0 +1,162 @@
+#include "snapshotloader.h"
+#include "venuesimulator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// End-to-end routing latency: loads the manifest books, puts an in-process venue simulator behind every
+// venue and reports tick-to-fill latency and slippage of alternating BUY/SELL parent orders.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+double to_us(std::chrono::nanoseconds value)
+{
+    return std::chrono::duration<double, std::micro>(value).count();
+}
+
+void print_row(const std::string& name, const std::vector<std::chrono::nanoseconds>& samples)
+{
+    LatencySummary summary = summarize_latencies(samples);
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << to_us(summary.p50) << std::setw(10) << to_us(summary.p90)
+              << std::setw(10) << to_us(summary.p99) << std::setw(10) << to_us(summary.max) << std::endl;
+}
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--manifest PATH] [--symbol NAME] [--orders N] [--size V]"
+              << " [--latency-us N] [--jitter-us N] [--partial P] [--competition P] [--tolerance-bps B]"
+              << " [--greedy] [--seed S]" << std::endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    std::string manifest_path = (fs::path(__FILE__).parent_path().parent_path() / "data/manifest.csv").string();
+    std::string symbol;
+    size_t orders = 100;
+    Volume order_size = 0.5;
+    VenueBehaviour behaviour;
+    double tolerance_bps = 0.0;
+    RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--greedy")
+        {
+            algorithm = RoutingAlgorithm::PURE_GREEDY;
+        }
+        else if (i + 1 < argc && arg == "--manifest")
+        {
+            manifest_path = argv[++i];
+        }
+        else if (i + 1 < argc && arg == "--symbol")
+        {
+            symbol = argv[++i];
+        }
+        else if (i + 1 < argc && arg == "--orders")
+        {
+            orders = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (i + 1 < argc && arg == "--size")
+        {
+            order_size = std::strtod(argv[++i], nullptr);
+        }
+        else if (i + 1 < argc && arg == "--latency-us")
+        {
+            behaviour.latency = std::chrono::microseconds(std::strtol(argv[++i], nullptr, 10));
+        }
+        else if (i + 1 < argc && arg == "--jitter-us")
+        {
+            behaviour.jitter = std::chrono::microseconds(std::strtol(argv[++i], nullptr, 10));
+        }
+        else if (i + 1 < argc && arg == "--partial")
+        {
+            behaviour.partial_fill_probability = std::strtod(argv[++i], nullptr);
+        }
+        else if (i + 1 < argc && arg == "--competition")
+        {
+            behaviour.competition_probability = std::strtod(argv[++i], nullptr);
+        }
+        else if (i + 1 < argc && arg == "--tolerance-bps")
+        {
+            tolerance_bps = std::strtod(argv[++i], nullptr);
+        }
+        else if (i + 1 < argc && arg == "--seed")
+        {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    SymbolRegistry registry;
+    LoadReport load = load_snapshots(registry, read_manifest(manifest_path));
+    if (load.failed > 0)
+    {
+        print_load_report(load, std::cerr);
+        return 1;
+    }
+    SymbolId id = symbol.empty() ? 0 : registry.get_symbol_id(symbol);
+
+    std::vector<std::unique_ptr<VenueSimulator>> venues;
+    for (const auto& book : registry.get_books(id))
+    {
+        venues.push_back(std::make_unique<VenueSimulator>(*book, behaviour, seed++));
+    }
+    SimulationDriver driver(registry.get_router(id), venues);
+    driver.set_limit_tolerance(tolerance_bps);
+
+    std::vector<std::chrono::nanoseconds> route, first_fill, last_fill;
+    std::vector<double> slippage;
+    Volume planned = 0.0, filled = 0.0;
+    size_t unrouted = 0;
+    for (size_t i = 0; i < orders; ++i)
+    {
+        RoundTrip trip = driver.execute(order_size, (i % 2 == 0) ? OrderSide::BUY : OrderSide::SELL, algorithm);
+        // The books are not replenished, so late orders may find a side exhausted
+        if (trip.plan.get_plan().empty())
+        {
+            ++unrouted;
+            continue;
+        }
+        route.push_back(trip.route_latency);
+        last_fill.push_back(trip.tick_to_last_fill);
+        if (trip.filled > 0.0)
+        {
+            first_fill.push_back(trip.tick_to_first_fill);
+            slippage.push_back(trip.slippage_bps);
+        }
+        for (const FillOrder& fill : trip.plan.get_plan()) planned += fill.volume;
+        filled += trip.filled;
+    }
+
+    std::cout << orders << " orders of " << order_size << " on " << registry.get_symbol(id) << ", "
+              << venues.size() << " venues, " << unrouted << " found no liquidity" << std::endl;
+    std::cout << "Latency (us)         p50       p90       p99       max" << std::endl;
+    print_row("Route", route);
+    print_row("Tick to first", first_fill);
+    print_row("Tick to last", last_fill);
+
+    std::sort(slippage.begin(), slippage.end());
+    double mean = 0.0;
+    for (double value : slippage) mean += value;
+    if (!slippage.empty()) mean /= static_cast<double>(slippage.size());
+    std::cout << std::setprecision(3) << "Slippage (bps)   mean " << mean
+              << ", p99 " << (slippage.empty() ? 0.0 : slippage[std::min(slippage.size() - 1, slippage.size() * 99 / 100)])
+              << std::endl;
+    std::cout << "Filled " << filled << " of " << planned << " planned ("
+              << (planned > 0.0 ? 100.0 * filled / planned : 0.0) << "%)" << std::endl;
+    return 0;
+}
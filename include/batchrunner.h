@@ -0,0 +1,48 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "planjournal.h"
+#include "smartorderrouter.h"
+#include <chrono>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+enum class BatchFormat
+{
+    CSV,            // One row per fill: order_id,side,algorithm,exchange,price,volume
+    JSON_LINES      // One object per order with its metrics and fills
+};
+
+struct BatchSummary
+{
+    size_t orders = 0;
+    size_t rejected = 0;            // Lines that could not be parsed
+    size_t fills = 0;
+    size_t routing_calls = 0;       // distribute_order calls; fewer than orders when netting
+    Volume netted_volume = 0.0;     // Crossed internally, per side
+    double elapsed_seconds = 0.0;
+    size_t netting_window = 0;      // Orders per netting window, 0 when every order was routed on its own
+    double latency_p50_us = 0.0;    // Routing latency only, parsing and output excluded; one sample per
+                                    // order, or one per netting window when netting
+    double latency_p99_us = 0.0;
+    double latency_max_us = 0.0;
+
+    double orders_per_second() const
+    {
+        return elapsed_seconds > 0.0 ? static_cast<double>(orders) / elapsed_seconds : 0.0;
+    }
+};
+
+// Routes orders streamed as "size,side,algorithm" lines (e.g. "1.5,BUY,H"; G, H or A) and writes each plan
+// through a buffered writer, which is flushed whenever no more input is buffered. Blank lines, '#'
+// comments and a non-numeric header are skipped.
+// Routed plans are also recorded to `journal` when one is given. With a netting window, every
+// `netting_window` consecutive orders are netted against each other (see net_and_route); a partial window
+// is routed as soon as no more input is buffered. Each order then reports the routing latency of its
+// whole window, and the percentiles take one sample per window.
+BatchSummary run_batch(SmartOrderRouter& router, std::istream& input, std::ostream& output, BatchFormat format,
+                       PlanJournal* journal = nullptr, size_t netting_window = 0);
+void print_batch_summary(const BatchSummary& summary, std::ostream& output);
+
+#endif // BATCHRUNNER_H
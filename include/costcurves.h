@@ -0,0 +1,34 @@
+#ifndef COSTCURVES_H
+#define COSTCURVES_H
+
+#include "orderbook.h"
+#include "threadpool.h"
+#include <chrono>
+#include <vector>
+
+// Cost of taking a venue's k cheapest lots, all of size lot_size: cumulative_cost[0] is 0
+struct VenueCostCurve
+{
+    Volume lot_size;
+    std::vector<Price> cumulative_cost;
+};
+
+struct CostCurveSolution
+{
+    std::vector<size_t> lots_per_venue;
+    Price cost = 0.0;
+};
+
+// Volume grid points the solver accepts; the merges are quadratic in it
+constexpr size_t MAX_COST_CURVE_GRID = 1 << 14;
+
+// Picks lots_per_venue to fill as much of `capacity` as possible at the lowest cost. The curves are
+// merged by min-plus convolution along a fixed pairwise tree, and each merged cell is computed
+// independently with ties going to the smaller left share, so the result does not depend on the
+// pool size. Returns false, leaving `solution` untouched, when the lot sizes share no common grid
+// of at most MAX_COST_CURVE_GRID points or the deadline passes mid-merge; the merge tasks check it
+// every few cells, so an expired deadline is noticed within one level.
+bool solve_cost_curves(const std::vector<VenueCostCurve>& curves, Volume capacity, ThreadPool* pool,
+                       std::chrono::steady_clock::time_point deadline, CostCurveSolution& solution);
+
+#endif // COSTCURVES_H
@@ -0,0 +1,81 @@
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+#include "smartorderrouter.h"
+#include "symbolregistry.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Randomized differential check of the routing algorithms against an exhaustive reference solver.
+// Cases are kept small enough for the reference to enumerate every plan.
+
+struct DifferentialVenue
+{
+    VenueConfig config;
+    std::vector<std::pair<Price, Volume>> bids;
+    std::vector<std::pair<Price, Volume>> asks;
+};
+
+struct DifferentialCase
+{
+    std::vector<DifferentialVenue> venues;
+    Volume order_size = 0.0;
+    OrderSide side = OrderSide::BUY;
+};
+
+// Volume filled and signed cost (cost for BUY, negated proceeds for SELL) of one plan
+struct DifferentialOutcome
+{
+    Volume volume = 0.0;
+    Price cost = 0.0;
+    std::chrono::nanoseconds latency{0};
+};
+
+struct DifferentialResult
+{
+    DifferentialOutcome reference;
+    DifferentialOutcome greedy;
+    DifferentialOutcome hybrid;
+
+    const DifferentialOutcome& get(RoutingAlgorithm algorithm) const
+    {
+        return algorithm == RoutingAlgorithm::HYBRID ? hybrid : greedy;
+    }
+};
+
+struct DifferentialShape
+{
+    std::vector<VenueConfig> venues;    // Fees and min order sizes of the generated books
+    size_t max_levels = 5;              // Per side and venue
+    Price mid_price = 100.0;
+    Price tick = 0.01;
+    Volume max_level_volume = 0.8;
+    Volume max_order_size = 1.5;
+};
+
+// Binance, KuCoin and OKX with the fees and min order sizes of the sample books
+DifferentialShape default_differential_shape();
+
+DifferentialCase generate_case(const DifferentialShape& shape, std::mt19937& rng);
+SmartOrderRouter build_router(const DifferentialCase& test_case);
+
+// Best plan over the whole books: most volume first, then lowest signed cost
+DifferentialOutcome solve_reference(const DifferentialCase& test_case);
+DifferentialResult run_differential(const DifferentialCase& test_case);
+
+// Cost gap and fulfillment difference of `algorithm` relative to the reference (both >= 0 when correct)
+Price get_cost_gap(const DifferentialResult& result, RoutingAlgorithm algorithm);
+Volume get_fulfillment_gap(const DifferentialResult& result, RoutingAlgorithm algorithm);
+bool diverges(const DifferentialResult& result, RoutingAlgorithm algorithm);
+
+// Drops venues, levels, lots and order size while `algorithm` keeps diverging from the reference
+DifferentialCase minimize_case(const DifferentialCase& test_case, RoutingAlgorithm algorithm);
+
+// One <exchange>_order_book.csv per venue in the data/ format, plus venues.csv and order.csv
+void save_case(const DifferentialCase& test_case, const std::string& directory);
+DifferentialCase load_case(const std::string& directory);
+
+#endif // DIFFERENTIAL_H
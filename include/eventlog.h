@@ -0,0 +1,180 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t
+{
+    TRACE,
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR,
+    OFF
+};
+
+// Usage: SOR_LOG(LogLevel::DEBUG, "Filled {} at {}", volume, price);
+// A disabled level costs one relaxed load. Enabled events store the format id and the raw
+// arguments in a per-thread ring; a consumer thread does the formatting and the I/O.
+#define SOR_LOG(level, format, ...)                                                          \
+    do                                                                                       \
+    {                                                                                        \
+        if (EventLog::is_enabled(level))                                                     \
+        {                                                                                    \
+            static const uint16_t sor_log_format_id = EventLog::register_format(level, format); \
+            EventLog::instance().write(sor_log_format_id, ##__VA_ARGS__);                    \
+        }                                                                                    \
+    } while (0)
+
+// Process-wide binary event logger. Lines are written to the output (std::cerr by default) as
+// "[<microseconds since start>] T<thread> <LEVEL> <message>"; "{}" in a format is replaced by the
+// next argument. A full ring drops the event and counts it instead of blocking the caller.
+class EventLog 
+{
+private:
+    enum class ArgType : uint8_t { INTEGER, UNSIGNED, REAL, STRING };
+
+    struct RecordHeader
+    {
+        uint32_t size;          // Whole record including this header, multiple of 8
+        uint16_t format_id;     // PADDING_FORMAT marks the unused tail before a wrap
+        uint8_t arg_count;
+        uint8_t reserved;
+        int64_t timestamp_ns;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<char[]> data;
+        alignas(64) std::atomic<uint64_t> head{0};  // Bytes written by the owning thread
+        alignas(64) std::atomic<uint64_t> tail{0};  // Bytes consumed by the writer thread
+        std::atomic<bool> retired{false};           // Owning thread exited
+        uint32_t thread_index = 0;
+    };
+
+    struct ThreadBufferOwner
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadBufferOwner();
+    };
+
+    static constexpr size_t BUFFER_SIZE = 1 << 20;     // Per thread
+    static constexpr size_t MAX_FORMATS = 4096;
+    static constexpr uint16_t PADDING_FORMAT = UINT16_MAX;
+    static constexpr size_t MAX_STRING_ARG = 255;
+
+    static std::atomic<uint8_t> s_level;
+
+    struct Format
+    {
+        LogLevel level;
+        const char* text;
+    };
+    Format m_formats[MAX_FORMATS];
+    std::atomic<size_t> m_format_count{0};
+    std::mutex m_format_mutex;
+
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    std::mutex m_buffers_mutex;
+    uint32_t m_next_thread_index = 0;
+
+    std::ostream* m_output;
+    std::mutex m_output_mutex;
+    std::chrono::steady_clock::time_point m_start;
+    std::atomic<uint64_t> m_dropped{0};
+    uint64_t m_dropped_reported = 0;    // Consumer-owned
+    std::atomic<bool> m_running{true};
+    std::thread m_consumer;
+
+    EventLog();
+    ThreadBuffer& get_thread_buffer();
+    char* reserve(ThreadBuffer& buffer, size_t size);
+    void consumer_loop();
+    bool drain();
+    void format_record(const RecordHeader& header, uint32_t thread_index, const char* args, std::string& line) const;
+
+    static size_t encoded_size(int64_t) { return 1 + sizeof(int64_t); }
+    static size_t encoded_size(uint64_t) { return 1 + sizeof(uint64_t); }
+    static size_t encoded_size(double) { return 1 + sizeof(double); }
+    static size_t encoded_size(const char* value) { return 2 + std::min(std::strlen(value), MAX_STRING_ARG); }
+    static size_t encoded_size(const std::string& value) { return 2 + std::min(value.size(), MAX_STRING_ARG); }
+
+    static char* encode(char* out, int64_t value) { *out = static_cast<char>(ArgType::INTEGER); std::memcpy(out + 1, &value, sizeof(value)); return out + 1 + sizeof(value); }
+    static char* encode(char* out, uint64_t value) { *out = static_cast<char>(ArgType::UNSIGNED); std::memcpy(out + 1, &value, sizeof(value)); return out + 1 + sizeof(value); }
+    static char* encode(char* out, double value) { *out = static_cast<char>(ArgType::REAL); std::memcpy(out + 1, &value, sizeof(value)); return out + 1 + sizeof(value); }
+    static char* encode(char* out, const char* value) { return encode_string(out, value, std::strlen(value)); }
+    static char* encode(char* out, const std::string& value) { return encode_string(out, value.data(), value.size()); }
+    static char* encode_string(char* out, const char* value, size_t length)
+    {
+        length = std::min(length, MAX_STRING_ARG);
+        out[0] = static_cast<char>(ArgType::STRING);
+        out[1] = static_cast<char>(length);
+        std::memcpy(out + 2, value, length);
+        return out + 2 + length;
+    }
+
+    // Arithmetic arguments are widened to one of the three stored types
+    template <typename T>
+    static decltype(auto) normalize(const T& value)
+    {
+        if constexpr (std::is_floating_point_v<T>) return static_cast<double>(value);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) return static_cast<int64_t>(value);
+        else if constexpr (std::is_integral_v<T>) return static_cast<uint64_t>(value);
+        else if constexpr (std::is_enum_v<T>) return static_cast<int64_t>(value);
+        else return static_cast<const T&>(value);
+    }
+
+public:
+    static EventLog& instance();
+    ~EventLog();
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    static bool is_enabled(LogLevel level)
+    {
+        return static_cast<uint8_t>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+    static void set_level(LogLevel level);
+    static LogLevel get_level();
+    // Accepts trace, debug, info, warning, error or off; throws std::invalid_argument otherwise
+    static LogLevel parse_level(const std::string& name);
+
+    static uint16_t register_format(LogLevel level, const char* format);
+
+    template <typename... Args>
+    void write(uint16_t format_id, const Args&... args)
+    {
+        size_t size = sizeof(RecordHeader) + (size_t{0} + ... + encoded_size(normalize(args)));
+        size = (size + 7) & ~static_cast<size_t>(7);
+        ThreadBuffer& buffer = get_thread_buffer();
+        char* out = reserve(buffer, size);
+        if (!out) return;
+
+        RecordHeader header{static_cast<uint32_t>(size), format_id, static_cast<uint8_t>(sizeof...(Args)), 0,
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()};
+        std::memcpy(out, &header, sizeof(header));
+        char* cursor = out + sizeof(header);
+        ((cursor = encode(cursor, normalize(args))), ...);
+        (void)cursor;
+        buffer.head.fetch_add(size, std::memory_order_release);
+    }
+
+    // Formatted lines go to `output` from now on; it must outlive the logger or be replaced
+    void set_output(std::ostream& output);
+    // Blocks until every event written so far has been formatted and flushed
+    void flush();
+    uint64_t get_dropped() const;
+};
+
+#endif // EVENTLOG_H
@@ -15,28 +15,36 @@ struct FillOrder
     ExchangeName exchange_name;
     Price price;
     Volume volume;
+    double fee_rate;            // Taker fee of the venue when the fill was planned
+    Price effective_price;      // Price with the fee applied for the plan's side, set by ExecutionPlan::add_fill
 
     // Default constructor
-    FillOrder() : exchange_name(""), price(0.0), volume(0.0) {}
+    FillOrder() : exchange_name(""), price(0.0), volume(0.0), fee_rate(0.0), effective_price(0.0) {}
 
-    FillOrder(ExchangeName name, Price p, Volume v)
-    : exchange_name(std::move(name)), price(p), volume(v) {}
+    // The fee is required: a forgotten one would silently skew effective_price and the plan totals
+    FillOrder(ExchangeName name, Price p, Volume v, double fee)
+    : exchange_name(std::move(name)), price(p), volume(v), fee_rate(fee), effective_price(0.0) {}
 };
 
+// Plan metrics are accumulated as fills are added, so every getter is O(1)
 class ExecutionPlan 
 {
 private:
     std::vector<FillOrder> m_plan;
-    std::shared_ptr<const std::unordered_map<ExchangeName, std::shared_ptr<class OrderBook>>> m_order_books;
     OrderSide m_side;
     Volume m_original_order_size;
+    Volume m_filled_volume = 0.0;
+    Price m_total = 0.0;
+    Price m_total_fees = 0.0;
+    bool m_optimizer_used = false;
+    bool m_proven_optimal = false;
+    Price m_optimality_gap = 0.0;
+    Volume m_optimality_volume_gap = 0.0;
+    Price m_coarsening_error_bound = 0.0;
+    Volume m_depth_limited_volume = 0.0;
 
 public:
-    // Constructor
-    ExecutionPlan(const std::vector<FillOrder>& plan,
-                std::shared_ptr<const std::unordered_map<ExchangeName, std::shared_ptr<class OrderBook>>> order_books,
-                OrderSide side,
-                Volume original_order_size);
+    ExecutionPlan(OrderSide side, Volume original_order_size);
 
     void add_fill(FillOrder fill);
 
@@ -48,8 +56,37 @@ public:
 
     Price get_average_effective_price() const;
     double get_fulfillment_percentage() const;
+    OrderSide get_side() const;
+    Volume get_original_order_size() const;
+
+    // Certificate of the HYBRID optimizer stage; greedy-only plans carry none
+    // The cost gap is measured at the plan's volume; the volume gap bounds how much more a complete
+    // search could have filled, so a cost gap of 0 only means optimal when the volume gap is 0 too
+    void set_optimality(bool proven_optimal, Price optimality_gap, Volume volume_gap = 0.0);
+    bool is_optimizer_used() const;
+    bool is_proven_optimal() const;
+    Price get_optimality_gap() const;
+    Volume get_optimality_volume_gap() const;
+    // Most the optimizer's fills can cost over the optimum of the uncoarsened levels; 0 without coarsening
+    void set_coarsening_error_bound(Price bound);
+    Price get_coarsening_error_bound() const;
+    // Unfilled volume that was resting in the venues' cold stores, outside their routing window
+    void set_depth_limited_volume(Volume volume);
+    Volume get_depth_limited_volume() const;
 
     void print() const;
+
+    // Compact binary form, host byte order like the wire protocol:
+    //   u8 side | u8 flags (1: optimizer used, 2: proven optimal) | f64 requested | f64 filled | f64 total
+    //   | f64 fees | f64 optimality_gap | f64 optimality_volume_gap | f64 coarsening_error_bound
+    //   | f64 depth_limited | u32 fill_count | fill_count x fill
+    //   fill: u8 name_length | name | f64 price | f64 volume | f64 fee_rate | f64 effective_price
+    void encode(std::string& out) const;
+    // Returns false on malformed input; on success `consumed` holds the encoded size
+    static bool decode(const char* data, size_t size, ExecutionPlan& plan, size_t& consumed);
+    // One JSON object with the metrics and the fills
+    std::string to_json() const;
+    void append_json(std::string& out) const;
 };
 
 #endif // EXECUTION_PLAN_H
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef LIQUIDITY_RESERVATION_H
+#define LIQUIDITY_RESERVATION_H
+
+#include "executionplan.h"
+#include "orderbook.h"
+#include <vector>
+
+// A routed plan whose liquidity is claimed but not yet consumed. Committing makes the
+// consumption final, releasing hands the volume back; a reservation dropped without
+// either is released.
+class LiquidityReservation
+{
+private:
+    ExecutionPlan m_plan;
+    std::vector<LiquidityClaim> m_claims;
+    bool m_active;
+
+public:
+    LiquidityReservation(ExecutionPlan plan, std::vector<LiquidityClaim> claims);
+    ~LiquidityReservation();
+    LiquidityReservation(LiquidityReservation&& other) noexcept;
+    LiquidityReservation& operator=(LiquidityReservation&& other) noexcept;
+    LiquidityReservation(const LiquidityReservation&) = delete;
+    LiquidityReservation& operator=(const LiquidityReservation&) = delete;
+
+    const ExecutionPlan& get_plan() const;
+    const std::vector<LiquidityClaim>& get_claims() const;
+    bool is_active() const;
+
+    ExecutionPlan commit();
+    void release();
+};
+
+#endif // LIQUIDITY_RESERVATION_H
@@ -0,0 +1,35 @@
+#ifndef NETTING_H
+#define NETTING_H
+
+#include "executionplan.h"
+#include "smartorderrouter.h"
+#include <cstddef>
+#include <vector>
+
+// Venue name of the fills that cross opposing parents against each other inside the router
+extern const ExchangeName INTERNAL_VENUE;
+
+struct ParentOrder
+{
+    Volume size;
+    OrderSide side;
+    RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID;
+};
+
+struct NettingResult
+{
+    std::vector<ExecutionPlan> plans;   // One per parent, in input order
+    Price reference_mid = 0.0;          // 0 when the books had no two-sided market
+    Volume crossed_volume = 0.0;        // Matched internally on each side
+    Volume residual_volume = 0.0;       // Net size sent to the books
+    size_t routing_calls = 0;           // distribute_order calls made for the batch
+};
+
+// Crosses opposing parents internally at the mid of the best bid and ask across venues, without fees,
+// then routes the net residual as one order and splits its fills over the parents of the net side in
+// proportion to what each still needs. Every parent's plan holds its INTERNAL_VENUE fill and its share
+// of the venue fills. Without a two-sided market, or when only one side is present, every parent is
+// routed on its own.
+NettingResult net_and_route(SmartOrderRouter& router, const std::vector<ParentOrder>& parents);
+
+#endif // NETTING_H
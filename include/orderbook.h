@@ -8,6 +8,9 @@
 #include <iomanip>
 #include <cmath>
 #include <memory>
+#include <cstdint>
+#include <atomic>
+#include <shared_mutex>
 
 // Aliases for price and volume
 using Price = double;
@@ -20,15 +23,121 @@ enum class OrderSide
     SELL
 };
 
+// Volume resting at one price. Routers claim from it with CAS while holding the book's read lock,
+// so concurrent plans never take the same liquidity; the owning book is the only writer otherwise.
+class PriceLevel
+{
+private:
+    mutable std::atomic<Volume> m_volume;
+
+    friend class OrderBook;
+    bool compare_exchange(Volume& expected, Volume desired) const;
+    // Returns the volume before the addition
+    Volume add(Volume volume) const;
+
+public:
+    PriceLevel(Volume volume = 0.0) : m_volume(volume) {}
+    PriceLevel(const PriceLevel& other) : m_volume(other.load()) {}
+    PriceLevel& operator=(const PriceLevel& other);
+    PriceLevel& operator+=(Volume volume);
+
+    Volume load() const { return m_volume.load(std::memory_order_acquire); }
+    operator Volume() const { return load(); }
+};
+
+using PriceLevels = std::map<Price, PriceLevel>;
+
+class OrderBook;
+
+// Volume taken from a level by an in-flight plan; it is either committed or released back
+struct LiquidityClaim
+{
+    OrderBook* book;
+    const PriceLevel* level;
+    Volume volume;
+    Price price;
+    OrderSide side;     // Side of the order holding the claim: BUY claims asks, SELL claims bids
+};
+
+// Resting liquidity on one side of a book. Levels fully claimed by in-flight plans are not counted.
+struct SideLiquidity
+{
+    Volume volume = 0.0;
+    Price notional = 0.0;       // Sum of price * volume, fees excluded
+    size_t levels = 0;
+    Price best_price = 0.0;     // 0 when the side is empty
+    Volume best_volume = 0.0;
+    Volume cold_volume = 0.0;   // Parked outside the routing window, not included above
+    size_t cold_levels = 0;
+};
+
+// Routing window of a book side. Levels beyond max_depth or further than price_band_bps from the best
+// price are parked in a cold store that routing never walks, and promoted as the top is consumed.
+// One plan therefore fills at most the window; ExecutionPlan::get_depth_limited_volume reports what the
+// cold store held of the shortfall. 0 disables a limit.
+struct DepthLimits
+{
+    size_t max_depth = 0;
+    double price_band_bps = 0.0;
+};
+
+struct LiquiditySnapshot
+{
+    ExchangeName exchange_name;
+    SideLiquidity bids;
+    SideLiquidity asks;
+    uint64_t version = 0;
+};
+
 
 class OrderBook 
 {
 private:
-    std::map<Price, Volume> m_bids; // Key: Price, Value: Total volume at that price
-    std::map<Price, Volume> m_asks; // Key: Price, Value: Total volume at that price
+    PriceLevels m_bids; // Key: Price, Value: Total volume at that price
+    PriceLevels m_asks; // Key: Price, Value: Total volume at that price
     ExchangeName m_exchange_name;   // Name of the exchange
     double m_taker_fee;            // Taker fee for the exchange
     Volume min_order_size;       // Minimum order size for the exchange
+    std::atomic<uint64_t> m_version{0};      // Bumped on every mutation of either side
+    std::atomic<uint64_t> m_pending_claims{0};  // Claims not yet committed or released
+    mutable std::shared_mutex m_mutex;          // Exclusive for inserting or erasing levels
+
+    // Kept up to date by every volume change, so snapshots never walk the levels
+    struct RunningTotals
+    {
+        std::atomic<Volume> volume{0.0};
+        std::atomic<Price> notional{0.0};
+        std::atomic<int64_t> levels{0};
+        std::atomic<uint64_t> changes{0};   // Bumped after every routable volume change of the side
+    };
+    RunningTotals m_bid_totals;
+    RunningTotals m_ask_totals;
+
+    // Levels outside the routing window; every cold price is worse than every hot one
+    struct ColdStore
+    {
+        std::map<Price, Volume> levels;
+        Volume volume = 0.0;
+    };
+    ColdStore m_cold_bids;
+    ColdStore m_cold_asks;
+    DepthLimits m_depth_limits;
+
+    // Levels may only be erased once no claim can still point at them. Callers hold the exclusive lock,
+    // so no new claim can start; they never wait for pending ones, whose owners may need the lock too
+    bool can_erase() const;
+    // Erases a level, or zeroes it in place for purge_depleted_levels while claims are pending
+    void drop_level(PriceLevels& levels, PriceLevels::iterator level);
+    RunningTotals& get_totals(OrderSide side);
+    // Records a level going from `before` to `after` resting volume
+    static void account(RunningTotals& totals, Price price, Volume before, Volume after);
+    // True when `price` belongs in the cold store of a side; callers hold the exclusive lock
+    static bool is_cold(const ColdStore& cold, bool bids, Price price);
+    // Replaces the volume of a cold level; volume <= 0 removes it
+    static void set_cold(ColdStore& cold, Price price, Volume volume);
+    // Demotes hot levels outside the window and promotes cold ones inside it; demotion waits for
+    // pending claims to settle. Returns true when any level moved
+    bool rebalance(bool bids);
 
 public:
     OrderBook(const std::string& exchange_name, double taker_fee, double min_order_size);
@@ -37,6 +146,10 @@ public:
     void add_ask(Price price, Volume volume);
     void reduce_bid_volume(Price price, Volume reduction);
     void reduce_ask_volume(Price price, Volume reduction);
+    // Replace the resting volume at a level (market data snapshot semantics); volume <= 0 removes it.
+    // A claim released after the update returns its volume on top of the new one
+    void set_bid_volume(Price price, Volume volume);
+    void set_ask_volume(Price price, Volume volume);
     Volume get_bid_volume(Price price) const;
     Volume get_ask_volume(Price price) const;
     void remove_top_bid();
@@ -45,10 +158,30 @@ public:
     std::pair<Price, Volume> get_best_ask() const;
     double get_taker_fee() const;
     Volume get_min_order_size() const;
-    const std::map<Price, Volume>& get_bids() const;
-    const std::map<Price, Volume>& get_asks() const;
+    uint64_t get_version() const;
+    // Changes only when routable volume on the side `side` consumes changes (BUY: asks, SELL: bids)
+    uint64_t get_side_version(OrderSide side) const;
+    // Iterating the levels while other threads may route requires holding read_lock()
+    const PriceLevels& get_bids() const;
+    const PriceLevels& get_asks() const;
     const ExchangeName get_exchange_name() const;
+    void set_depth_limits(const DepthLimits& limits);
+    DepthLimits get_depth_limits() const;
+    // Cold volume on the side `side` consumes; callers hold read_lock()
+    Volume get_cold_volume(OrderSide side) const;
     void print_order_book() const;
+    // O(1): reads the running totals and the top of each side
+    LiquiditySnapshot get_liquidity_snapshot() const;
+
+    // Concurrent routing: walk the levels under read_lock(), claim with try_claim(),
+    // then commit_claim() or release_claim() every successful claim
+    std::shared_lock<std::shared_mutex> read_lock() const;
+    // `level` must be on the side `side` consumes. On failure `observed` holds the level's current volume
+    bool try_claim(OrderSide side, PriceLevels::const_iterator level, Volume& observed, Volume volume);
+    void commit_claim(const LiquidityClaim& claim);
+    void release_claim(const LiquidityClaim& claim);
+    // Erases fully claimed levels and runs deferred demotions; skipped when the book is busy or claims are still pending
+    void purge_depleted_levels();
 };
 
-#endif // ORDERBOOK_H
\ No newline at end of file
+#endif // ORDERBOOK_H
@@ -0,0 +1,146 @@
+#ifndef PLANJOURNAL_H
+#define PLANJOURNAL_H
+
+#include "executionplan.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Append-only binary journal of routed plans. record() copies the plan into a lock-free
+// single-producer/single-consumer ring and returns; a background thread drains the ring into a
+// pre-allocated memory-mapped file. When the ring or the file is full the plan is counted as
+// dropped rather than blocking the router.
+//
+// File layout (host byte order, every record 8-byte aligned):
+//   JournalFileHeader
+//   records: u32 type | u32 size (bytes, including this header) | body
+//     VENUE: u32 venue_id | u32 name_length | name (padded)
+//     PLAN:  u64 sequence | i64 timestamp_ns | f64 requested | f64 total | f64 fees | f64 optimality_gap
+//            | u8 side | u8 flags | u16 reserved | u32 fill_count | fill_count x JournalFill
+// Plans reference venues by id; the VENUE record for an id always precedes its first use. VENUE records
+// are written together with that first plan, and once a plan does not fit nothing more is written.
+
+constexpr char JOURNAL_MAGIC[8] = {'S', 'O', 'R', 'J', 'R', 'N', 'L', '1'};
+
+struct JournalFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;          // File size in bytes
+    uint64_t write_offset;      // End of the last complete record
+    uint64_t plans;
+    uint64_t dropped;
+};
+
+enum class JournalRecordType : uint32_t
+{
+    VENUE = 1,
+    PLAN = 2
+};
+
+enum JournalPlanFlags : uint8_t
+{
+    JOURNAL_OPTIMIZER_USED = 1,
+    JOURNAL_PROVEN_OPTIMAL = 2
+};
+
+struct JournalFill
+{
+    uint32_t venue_id;
+    uint32_t reserved;
+    Price price;
+    Volume volume;
+};
+
+// A decoded PLAN record
+struct JournalEntry
+{
+    uint64_t sequence;
+    int64_t timestamp_ns;       // System clock, nanoseconds since the epoch
+    OrderSide side;
+    uint8_t flags;
+    Volume requested;
+    Price total;
+    Price fees;
+    Price optimality_gap;
+    std::vector<FillOrder> fills;
+};
+
+struct JournalContents
+{
+    JournalFileHeader header;
+    std::vector<JournalEntry> entries;
+};
+
+// Throws std::runtime_error on a missing, truncated or foreign file
+JournalContents read_journal(const std::string& path);
+
+class PlanJournal 
+{
+private:
+    static constexpr size_t FILLS_PER_SLOT = 8;
+    static constexpr size_t VENUE_NAME_SIZE = 64;
+
+    // One ring element: a venue definition, a plan header with its first fills, or more fills of that plan
+    struct Slot
+    {
+        enum class Kind : uint8_t { VENUE, PLAN, FILLS } kind;
+        uint8_t side;
+        uint8_t flags;
+        uint8_t fill_count;     // Fills carried by this slot
+        uint32_t total_fills;   // PLAN: fills in the whole plan
+        uint64_t sequence;
+        int64_t timestamp_ns;
+        Volume requested;
+        Price total;
+        Price fees;
+        Price optimality_gap;
+        JournalFill fills[FILLS_PER_SLOT];
+        char venue_name[VENUE_NAME_SIZE];   // VENUE only; fills[0].venue_id carries the id
+    };
+
+    std::vector<Slot> m_ring;
+    size_t m_mask;
+    alignas(64) std::atomic<uint64_t> m_head{0};   // Next slot the producer writes
+    alignas(64) std::atomic<uint64_t> m_tail{0};   // Next slot the consumer reads
+    alignas(64) uint64_t m_next_sequence = 0;       // Producer-owned
+    std::unordered_map<ExchangeName, uint32_t> m_venue_ids;   // Producer-owned
+
+    int m_fd = -1;
+    char* m_map = nullptr;
+    size_t m_capacity = 0;
+    size_t m_write_offset = 0;
+    bool m_full = false;        // Writer-owned: set by the first plan that did not fit
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<bool> m_running{true};
+    std::thread m_writer;
+
+    void writer_loop();
+    bool drain();
+    char* reserve_record(JournalRecordType type, size_t body_size);
+    void publish_header();
+
+public:
+    // Creates (or truncates) `path` and pre-allocates `capacity_bytes`; ring_slots is rounded up to a power of two
+    PlanJournal(const std::string& path, size_t capacity_bytes, size_t ring_slots = 1 << 14);
+    ~PlanJournal();
+    PlanJournal(const PlanJournal&) = delete;
+    PlanJournal& operator=(const PlanJournal&) = delete;
+
+    // Producer side: call from one thread only. Never blocks; returns false if the plan was dropped.
+    bool record(const ExecutionPlan& plan);
+
+    // Blocks until every plan recorded so far is in the file
+    void flush();
+    uint64_t get_written() const;
+    uint64_t get_dropped() const;
+};
+
+#endif // PLANJOURNAL_H
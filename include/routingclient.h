@@ -0,0 +1,37 @@
+#ifndef ROUTINGCLIENT_H
+#define ROUTINGCLIENT_H
+
+#include "wireprotocol.h"
+#include <cstdint>
+#include <string>
+
+// Blocking client for RoutingServer. Requests are encoded with the wireprotocol.h encoders and may
+// be pipelined: send() any number of frames, then receive() their responses in order.
+class RoutingClient 
+{
+private:
+    int m_fd = -1;
+    std::string m_input;
+    size_t m_input_offset = 0;
+
+    static constexpr size_t READ_CHUNK = 64 << 10;
+
+public:
+    RoutingClient() = default;
+    ~RoutingClient();
+    RoutingClient(const RoutingClient&) = delete;
+    RoutingClient& operator=(const RoutingClient&) = delete;
+
+    // Throw std::runtime_error if the connection fails
+    void connect_unix(const std::string& path);
+    void connect_tcp(uint16_t port);    // Connects to 127.0.0.1
+
+    void send(const std::string& frames);
+    // Half-closes the connection: the server answers every frame already sent, then closes
+    void finish_sending();
+    // Waits for the next response frame; returns false once the server closes the connection
+    bool receive(WireHeader& header, std::string& payload);
+    void close();
+};
+
+#endif // ROUTINGCLIENT_H
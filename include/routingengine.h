@@ -0,0 +1,80 @@
+#ifndef ROUTINGENGINE_H
+#define ROUTINGENGINE_H
+
+#include "symbolregistry.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+struct ShardStats
+{
+    uint64_t orders_routed;
+    uint64_t quotes_served;
+    uint64_t quotes_stolen;     // Quotes this worker took from another shard's queue
+};
+
+// Shards symbols across worker threads. An order only ever runs on the worker owning its symbol,
+// which is therefore the only thread mutating that symbol's books. Quotes are read-only and are
+// stolen by idle workers when the owning shard is busy.
+// The registry must not gain symbols or venues while the engine is running.
+class RoutingEngine
+{
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        bool is_order;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Task> orders;        // Pinned to this worker
+        std::deque<Task> quotes;        // Owner pops from the back, thieves from the front
+        std::atomic<uint64_t> orders_routed{0};
+        std::atomic<uint64_t> quotes_served{0};
+        std::atomic<uint64_t> quotes_stolen{0};
+        std::thread thread;
+    };
+
+    static constexpr std::chrono::milliseconds IDLE_POLL{1};
+
+    SymbolRegistry& m_registry;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::unique_ptr<std::shared_mutex>> m_symbol_locks;   // Exclusive for orders, shared for quotes
+    std::atomic<bool> m_stopping{false};
+    std::atomic<size_t> m_next_thief{0};
+
+    void run_worker(size_t index);
+    bool try_steal_quote(size_t thief, Task& task);
+    void enqueue(size_t shard, Task task);
+    void check_symbol(SymbolId id) const;
+
+public:
+    explicit RoutingEngine(SymbolRegistry& registry, size_t shard_count = std::thread::hardware_concurrency());
+    ~RoutingEngine();
+    RoutingEngine(const RoutingEngine&) = delete;
+    RoutingEngine& operator=(const RoutingEngine&) = delete;
+
+    size_t get_shard_count() const;
+    size_t get_shard(SymbolId id) const;
+
+    std::future<ExecutionPlan> submit_order(SymbolId id, Volume order_size, OrderSide side,
+                                            RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                                            std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET);
+    std::future<ExecutionPlan> submit_quote(SymbolId id, Volume order_size, OrderSide side,
+                                            RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                                            std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET);
+
+    std::vector<ShardStats> get_shard_stats() const;
+};
+
+#endif // ROUTINGENGINE_H
@@ -0,0 +1,74 @@
+#ifndef ROUTINGSERVER_H
+#define ROUTINGSERVER_H
+
+#include "planjournal.h"
+#include "smartorderrouter.h"
+#include "wireprotocol.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Single-threaded epoll event loop serving one router over a Unix domain socket or loopback TCP.
+// Requests use the framing in wireprotocol.h and are answered in arrival order per connection,
+// so clients can pipeline without waiting for each response.
+class RoutingServer 
+{
+private:
+    struct Connection
+    {
+        int fd;
+        std::string input;
+        size_t input_offset = 0;    // Start of the first unparsed frame
+        std::string output;
+        size_t output_offset = 0;   // Start of the unsent responses
+        uint32_t events = 0;        // Currently registered epoll events
+        bool input_closed = false;  // The peer shut down its sending side; answer what it sent, then close
+    };
+
+    SmartOrderRouter& m_router;
+    PlanJournal* m_journal = nullptr;
+    int m_epoll_fd = -1;
+    int m_wake_fd = -1;     // eventfd written by stop()
+    int m_listen_fd = -1;
+    uint16_t m_port = 0;
+    std::string m_unix_path;
+    std::unordered_map<int, Connection> m_connections;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_requests_served{0};
+
+    // Stop reading from a client that is not draining its responses
+    static constexpr size_t OUTPUT_HIGH_WATERMARK = 4 << 20;
+    static constexpr size_t READ_CHUNK = 64 << 10;
+
+    void start_listening(int fd);
+    void accept_connections();
+    bool receive_input(Connection& connection);
+    bool has_buffered_frame(const Connection& connection) const;
+    size_t pending_output(const Connection& connection) const;
+    bool process_frames(Connection& connection);
+    bool flush_connection(Connection& connection);
+    void update_events(Connection& connection);
+    void close_connection(int fd);
+    void handle_frame(Connection& connection, const WireHeader& header, const char* payload);
+
+public:
+    explicit RoutingServer(SmartOrderRouter& router);
+    ~RoutingServer();
+    RoutingServer(const RoutingServer&) = delete;
+    RoutingServer& operator=(const RoutingServer&) = delete;
+
+    // Throw std::runtime_error if the socket cannot be set up; call one of them before run()
+    void listen_unix(const std::string& path);
+    void listen_tcp(uint16_t port);     // Binds 127.0.0.1; port 0 picks an ephemeral port
+    uint16_t get_port() const;
+    // Records every distributed plan; the event loop is the journal's only producer
+    void set_journal(PlanJournal* journal);
+
+    // Blocks until stop() is called; stop() is safe from other threads and signal handlers
+    void run();
+    void stop();
+    uint64_t get_requests_served() const;
+};
+
+#endif // ROUTINGSERVER_H
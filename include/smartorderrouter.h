@@ -1,23 +1,124 @@
 #ifndef SMARTORDERROUTER_H
 #define SMARTORDERROUTER_H
 
-#ifdef DEBUG_MODE
-    #define DEBUG_LOG(x) std::cout << x << std::endl
-#else
-    #define DEBUG_LOG(x)
-#endif
-
+#include "eventlog.h"
 #include "executionplan.h"
+#include "liquidityreservation.h"
 #include "orderbook.h"
 #include <queue>
+#include <atomic>
 #include <vector>
 #include <functional>
 #include <memory>
+#include <chrono>
+#include <mutex>
+#include <tuple>
+#include <map>
+#include <unordered_map>
 
 enum class RoutingAlgorithm 
 {
     PURE_GREEDY,
-    HYBRID   
+    HYBRID,
+    ADAPTIVE    // HYBRID that switches to the optimizer only when its cost model expects it to pay off
+};
+
+// Pass as latency_budget to let the optimizer search until it proves optimality
+constexpr std::chrono::microseconds NO_LATENCY_BUDGET = std::chrono::microseconds::max();
+
+struct OptimizerResult
+{
+    std::vector<FillOrder> fills;
+    bool proven_optimal;
+    Price optimality_gap;   // Incumbent cost minus the LP relaxation bound at the incumbent's volume (0 when proven optimal)
+    Volume volume_gap = 0.0;    // Reachable volume bound minus the incumbent's volume (0 when proven optimal)
+    Price coarsening_error_bound = 0.0;     // Extra cost the coarsened search may have accepted
+};
+
+// Merges a venue's adjacent candidate levels within bucket_bps of the bucket's best level into one
+// bucket priced at its worst level, so the search sees O(log lots) items per bucket instead of every
+// lot. The chosen buckets are refined back into their best real levels. 0 disables coarsening
+struct OptimizerCoarsening
+{
+    double bucket_bps = 0.0;
+    size_t min_lots = 64;       // Residuals with fewer candidate lots are searched exactly
+};
+
+struct OptimizerCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;                 // Lookups that found an entry built on older book versions
+    std::chrono::nanoseconds saved_latency{0};  // Optimizer time recorded for the entries that were hit
+
+    double hit_rate() const
+    {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+};
+
+struct QuoteLadderStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;                            // Ladder quotes that found their side changed and rebuilt it
+    std::chrono::nanoseconds refresh_time{0};       // Total spent rebuilding ladders
+    std::chrono::nanoseconds last_refresh_time{0};
+
+    double hit_rate() const
+    {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+};
+
+// Plans are compared by signed cost plus a shortfall charge: volume left unfilled is valued at the best
+// effective price at the switch point plus shortfall_penalty_bps
+struct AdaptiveHybridConfig
+{
+    double latency_cost_per_us = 0.0001;    // Price units one microsecond of optimizer time is worth
+    double shortfall_penalty_bps = 10.0;
+    uint64_t warmup_runs = 8;               // Optimizer runs per lot bucket before its estimates are used
+    uint64_t explore_interval = 32;         // Every Nth declined switch in a bucket runs the optimizer anyway
+    double smoothing = 0.1;                 // Weight of the newest run in the bucket averages
+};
+
+// Calibration of the residuals whose estimated candidate lot count is in [min_lots, 2 * min_lots)
+struct AdaptiveBucketStats
+{
+    size_t min_lots;
+    uint64_t runs;
+    double runtime_us;      // Smoothed optimizer latency
+    double benefit_bps;     // Smoothed benefit over finishing greedily, in bps of the residual's notional
+};
+
+struct AdaptiveHybridStats
+{
+    uint64_t decisions = 0;
+    uint64_t optimizer_runs = 0;
+    uint64_t declined = 0;
+    uint64_t explorations = 0;              // Runs made for warm-up or exploration rather than on the estimate
+    Price predicted_benefit = 0.0;          // Sum over runs made on the estimate
+    Price realized_benefit = 0.0;           // Same runs, measured against the greedy finish
+    double predicted_runtime_us = 0.0;
+    double runtime_us = 0.0;
+    std::vector<AdaptiveBucketStats> buckets;   // Buckets with at least one run, by lot count
+};
+
+struct LadderQuote
+{
+    Volume size;
+    Volume filled;
+    Price total;            // Cost for BUY, proceeds for SELL, fees included
+    Price average_price;
+};
+
+struct VenueLiquidity
+{
+    ExchangeName exchange_name;
+    Price best_price;       // 0 when the side is empty
+    Volume volume;
+    size_t levels;
 };
 
 struct DPFill 
@@ -33,6 +134,7 @@ struct BestOrder {
     Volume volume;
     Price original_price;
     double fee;
+    size_t venue_index;
     
     struct BuyComparator 
     {
@@ -57,18 +159,164 @@ private:
     std::unique_ptr<std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>>> m_order_books;
     
     using Comparator = std::function<bool(const BestOrder&, const BestOrder&)>;
+
+    // Walk position inside one venue's book side. Planned fills are tracked here instead of
+    // being applied to the book, so quotes can run the same walk without mutating anything
+    struct VenueCursor
+    {
+        OrderBook* book;
+        const PriceLevels* levels;
+        PriceLevels::const_iterator level;
+        Volume level_volume;    // Volume left at *level after the planned fills
+        bool exhausted;
+    };
+
+    // Proven-optimal optimizer results keyed by (side, residual in EPSILON ticks); an entry is only
+    // valid while every venue is at the version and walk position it was computed on
+    using BookState = std::vector<std::tuple<uint64_t, Price, Volume>>;
+    struct OptimizerCacheEntry
+    {
+        BookState book_state;
+        OptimizerResult result;
+        std::chrono::nanoseconds compute_time;
+    };
+    struct OptimizerCache
+    {
+        std::mutex mutex;
+        std::map<std::pair<OrderSide, long long>, OptimizerCacheEntry> entries;
+        OptimizerCacheStats stats;
+    };
+    static constexpr size_t OPTIMIZER_CACHE_CAPACITY = 4096;
+    std::unique_ptr<OptimizerCache> m_optimizer_cache;
+
+    // Optimizer fills whose levels were taken concurrently are re-planned this many times
+    static constexpr int OPTIMIZER_CLAIM_ATTEMPTS = 3;
+
+    // Residuals with at least this many candidate lots are solved by merging per-venue cost curves on
+    // the shared thread pool instead of the serial branch and bound
+    static constexpr size_t PARALLEL_OPTIMIZER_MIN_LOTS = 256;
+    size_t m_parallel_optimizer_min_lots = PARALLEL_OPTIMIZER_MIN_LOTS;
+    OptimizerCoarsening m_optimizer_coarsening;
+
+    // Quotes for a fixed ladder of sizes, one ladder per side (indexed by OrderSide). A side is rebuilt
+    // on its next lookup once any book's side version moved past the versions it was built on
+    struct QuoteLadderSide
+    {
+        std::vector<Volume> sizes;      // Ascending
+        RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID;
+        std::vector<uint64_t> side_versions;    // Empty until the side is first built
+        std::vector<ExecutionPlan> plans;
+    };
+    // Sides are immutable snapshots swapped with std::atomic_load / atomic_compare_exchange, so lookups
+    // never lock; one thread per side rebuilds, outside any lock other quotes wait on
+    struct QuoteLadder
+    {
+        std::shared_ptr<const QuoteLadderSide> sides[2];
+        std::mutex rebuilding[2];
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<int64_t> refresh_time_ns{0};
+        std::atomic<int64_t> last_refresh_time_ns{0};
+    };
+    std::unique_ptr<QuoteLadder> m_quote_ladder;
+
+    // Online cost model behind RoutingAlgorithm::ADAPTIVE, one bucket per power of two of candidate lots
+    static constexpr size_t ADAPTIVE_BUCKETS = 24;
+    struct AdaptiveModel
+    {
+        struct Bucket
+        {
+            uint64_t runs = 0;
+            uint64_t declined_since_run = 0;
+            double runtime_us = 0.0;
+            double benefit_bps = 0.0;
+        };
+
+        std::mutex mutex;
+        AdaptiveHybridConfig config;
+        Bucket buckets[ADAPTIVE_BUCKETS];
+        AdaptiveHybridStats stats;
+    };
+    std::unique_ptr<AdaptiveModel> m_adaptive_model;
+
+    struct AdaptiveDecision
+    {
+        bool optimize = false;
+        bool exploring = false;
+        size_t bucket = 0;
+        Volume residual = 0.0;
+        Price reference_price = 0.0;    // Best effective price at the switch point
+        Price greedy_objective = 0.0;   // Signed cost plus shortfall of finishing greedily
+        Price predicted_benefit = 0.0;
+        double predicted_runtime_us = 0.0;
+    };
+    // Signed cost of `fills` plus the shortfall charge for the part of `residual` they leave unfilled
+    Price get_adaptive_objective(const std::vector<FillOrder>& fills, Volume residual, OrderSide side,
+                                 Price reference_price, double shortfall_penalty_bps) const;
+    AdaptiveDecision decide_adaptive(Volume remaining_size, OrderSide side, const std::vector<VenueCursor>& cursors,
+                                     const std::vector<FillOrder>& greedy_finish) const;
+    void record_adaptive_run(const AdaptiveDecision& decision, OrderSide side, const std::vector<FillOrder>& fills,
+                             std::chrono::nanoseconds runtime) const;
+
+    std::vector<uint64_t> get_side_versions(OrderSide side) const;
+    // Current ladder of a side, rebuilt first when stale. Returns nullptr when no ladder is set, or when
+    // another thread is rebuilding the side and `wait` is false
+    std::shared_ptr<const QuoteLadderSide> refresh_quote_ladder(OrderSide side, bool wait) const;
+
+    LiquidityReservation route_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                     std::chrono::microseconds latency_budget, bool claim_liquidity) const;
+    bool claim_optimized_fills(const std::vector<FillOrder>& fills, OrderSide side,
+                               const std::vector<VenueCursor>& cursors, std::vector<LiquidityClaim>& claims) const;
+    BookState get_book_state(const std::vector<VenueCursor>& cursors) const;
+    OptimizerResult optimize_residual(Volume remaining_size, OrderSide side, const std::vector<VenueCursor>& cursors,
+                                      std::chrono::steady_clock::time_point deadline) const;
     
     Volume get_largest_min_lot_size(const std::priority_queue<BestOrder, std::vector<BestOrder>, Comparator>& best_orders) const;
-    std::vector<FillOrder> distribute_order_optimized(Volume remaining_size, OrderSide side, const std::priority_queue<BestOrder, std::vector<BestOrder>, Comparator>& best_orders) const;
+    OptimizerResult distribute_order_optimized(Volume remaining_size, OrderSide side, const std::vector<VenueCursor>& cursors,
+                                               std::chrono::steady_clock::time_point deadline) const;
 
 public:
     SmartOrderRouter(std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>> order_books);
     SmartOrderRouter(SmartOrderRouter&& other) noexcept = default;
     SmartOrderRouter(const SmartOrderRouter&) = delete;
     SmartOrderRouter& operator=(const SmartOrderRouter&) = delete;
-    ExecutionPlan distribute_order(Volume order_size, OrderSide m_side, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID) const;
+    // latency_budget bounds the HYBRID optimizer: when it expires the best plan found so far is returned.
+    // Only the venues' routing windows are walked, see DepthLimits
+    ExecutionPlan distribute_order(Volume order_size, OrderSide m_side, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                                   std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET) const;
+
+    // Plans the order and claims its liquidity; other routers cannot take it until it is released.
+    // distribute_order is reserve_order followed by commit
+    LiquidityReservation reserve_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                                       std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET) const;
+
+    // Same plan distribute_order would produce right now, without consuming any liquidity
+    ExecutionPlan quote(Volume order_size, OrderSide side, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                        std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET) const;
+
+    void print_remaining_liquidity(std::ostream& output = std::cout) const;
+    // Resting liquidity per venue on one side, sorted by exchange name
+    std::vector<VenueLiquidity> get_liquidity(OrderSide side) const;
+    // Running totals of every book, sorted by exchange name; no level is walked
+    std::vector<LiquiditySnapshot> get_liquidity_snapshots() const;
+
+    // Quotes at these sizes for `algorithm` without a latency budget are answered from a cached ladder
+    void set_quote_ladder(std::vector<Volume> sizes, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID);
+    std::vector<LadderQuote> get_quote_ladder(OrderSide side) const;
+    QuoteLadderStats get_quote_ladder_stats() const;
+
+    // Crossover between the serial and the parallel optimizer, in candidate lots
+    void set_parallel_optimizer_threshold(size_t min_lots);
+    // Not thread-safe with routing; clears the optimizer cache
+    void set_optimizer_coarsening(const OptimizerCoarsening& coarsening);
+
+    OptimizerCacheStats get_optimizer_cache_stats() const;
+    void clear_optimizer_cache();
 
-    void print_remaining_liquidity() const;
+    // ADAPTIVE decisions also learn from quotes, so a quote may explore where the order would not
+    void set_adaptive_config(const AdaptiveHybridConfig& config);
+    AdaptiveHybridStats get_adaptive_stats() const;
+    void clear_adaptive_model();
 };
 
 #endif // SMARTORDERROUTER_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOTLOADER_H
+#define SNAPSHOTLOADER_H
+
+#include "symbolregistry.h"
+#include "threadpool.h"
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One venue book of one symbol: "Symbol,Exchange,TakerFee,MinOrderSize,File" in the manifest
+struct ManifestEntry
+{
+    std::string symbol;
+    VenueConfig venue;
+    std::string file;       // Relative paths are resolved against the manifest's directory
+};
+
+struct FileLoadTiming
+{
+    std::string symbol;
+    ExchangeName exchange_name;
+    std::string file;
+    size_t rows = 0;
+    std::chrono::microseconds elapsed{0};
+    std::string error;      // Empty when the file loaded
+};
+
+struct LoadReport
+{
+    std::vector<FileLoadTiming> files;      // In manifest order
+    std::chrono::microseconds elapsed{0};   // Wall time of the whole load
+    size_t failed = 0;
+};
+
+// Throws std::runtime_error when the manifest cannot be read or a row is malformed
+std::vector<ManifestEntry> read_manifest(const std::string& path);
+
+// Registers every symbol and venue, then parses the snapshot files concurrently on `pool`.
+// Routers are built from the registry afterwards, once every book is complete. A venue listed twice
+// for one symbol throws; unreadable files are reported in the LoadReport instead.
+LoadReport load_snapshots(SymbolRegistry& registry, const std::vector<ManifestEntry>& manifest,
+                          ThreadPool& pool = ThreadPool::shared());
+void print_load_report(const LoadReport& report, std::ostream& output);
+
+#endif // SNAPSHOTLOADER_H
@@ -0,0 +1,113 @@
+#ifndef SOR_C_H
+#define SOR_C_H
+
+/* Stable C interface to the smart order router (libsor).
+ *
+ * A sor_router routes one instrument across its venues. All results are written into
+ * caller-provided buffers, so no memory allocated by the library crosses this boundary and
+ * no C++ exception escapes it. Routing calls may run concurrently on one router; adding
+ * venues must not overlap with any other call on the same router. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+    #define SOR_API __declspec(dllexport)
+#else
+    #define SOR_API __attribute__((visibility("default")))
+#endif
+
+#define SOR_EXCHANGE_NAME_SIZE 32   /* Including the terminating NUL; longer names are rejected */
+#define SOR_NO_LATENCY_BUDGET (-1)
+
+typedef struct sor_router sor_router;
+
+typedef enum
+{
+    SOR_OK = 0,
+    SOR_INVALID_ARGUMENT = 1,
+    SOR_UNKNOWN_VENUE = 2,
+    SOR_DUPLICATE_VENUE = 3,
+    SOR_BUFFER_TOO_SMALL = 4,   /* Nothing was routed; the required count is still reported */
+    SOR_INTERNAL_ERROR = 5
+} sor_status;
+
+typedef enum
+{
+    SOR_BUY = 0,
+    SOR_SELL = 1
+} sor_side;
+
+typedef enum
+{
+    SOR_BID = 0,
+    SOR_ASK = 1
+} sor_book_side;
+
+typedef enum
+{
+    SOR_PURE_GREEDY = 0,
+    SOR_HYBRID = 1,
+    SOR_ADAPTIVE = 2
+} sor_algorithm;
+
+typedef struct
+{
+    char exchange_name[SOR_EXCHANGE_NAME_SIZE];
+    double price;
+    double volume;
+} sor_fill;
+
+typedef struct
+{
+    size_t fill_count;          /* Fills written, or required when SOR_BUFFER_TOO_SMALL */
+    double filled_volume;
+    double total;               /* Notional including fees */
+    double fees;
+    double average_price;       /* Average effective price, fees included */
+    int optimizer_used;
+    int proven_optimal;
+} sor_plan_summary;
+
+typedef struct
+{
+    char exchange_name[SOR_EXCHANGE_NAME_SIZE];
+    double best_price;
+    double volume;
+    size_t levels;
+} sor_venue_liquidity;
+
+SOR_API sor_router* sor_router_create(void);
+SOR_API void sor_router_destroy(sor_router* router);
+
+/* taker_fee must be finite and >= 0, min_order_size finite and > 0 */
+SOR_API sor_status sor_add_venue(sor_router* router, const char* exchange_name, double taker_fee, double min_order_size);
+
+/* Sets the resting volume at one price level; volume <= 0 removes the level */
+SOR_API sor_status sor_set_level(sor_router* router, const char* exchange_name, sor_book_side side,
+                                 double price, double volume);
+
+/* distribute consumes the routed liquidity, quote leaves the books untouched.
+ * latency_budget_us < 0 lets the optimizer run until it proves optimality. */
+SOR_API sor_status sor_distribute_order(sor_router* router, double size, sor_side side, sor_algorithm algorithm,
+                                        int64_t latency_budget_us, sor_fill* fills, size_t fill_capacity,
+                                        sor_plan_summary* summary);
+SOR_API sor_status sor_quote(sor_router* router, double size, sor_side side, sor_algorithm algorithm,
+                             int64_t latency_budget_us, sor_fill* fills, size_t fill_capacity,
+                             sor_plan_summary* summary);
+
+/* Liquidity available to an order of the given side, one entry per venue sorted by name */
+SOR_API sor_status sor_get_liquidity(sor_router* router, sor_side side, sor_venue_liquidity* venues,
+                                     size_t venue_capacity, size_t* venue_count);
+
+SOR_API const char* sor_status_string(sor_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOR_C_H */
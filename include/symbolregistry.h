@@ -0,0 +1,57 @@
+#ifndef SYMBOLREGISTRY_H
+#define SYMBOLREGISTRY_H
+
+#include "orderbook.h"
+#include "smartorderrouter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using SymbolId = uint32_t;
+
+struct VenueConfig
+{
+    ExchangeName exchange_name;
+    double taker_fee;
+    Volume min_order_size;
+    DepthLimits depth_limits = {};      // Unbounded unless set
+};
+
+// Maps instruments to their per-venue books. Symbols are addressed by dense ids,
+// so routing is a vector index regardless of how many symbols are loaded.
+class SymbolRegistry
+{
+private:
+    struct SymbolEntry
+    {
+        std::string symbol;
+        std::vector<std::shared_ptr<OrderBook>> books;
+        std::unique_ptr<SmartOrderRouter> router;   // Built on first route, idle symbols carry only their books
+    };
+
+    std::vector<SymbolEntry> m_symbols;            // Indexed by SymbolId
+    std::unordered_map<std::string, SymbolId> m_symbol_ids;
+
+    SymbolEntry& get_entry(SymbolId id);
+    const SymbolEntry& get_entry(SymbolId id) const;
+
+public:
+    // Returns the existing id if the symbol is already registered
+    SymbolId register_symbol(const std::string& symbol);
+    std::shared_ptr<OrderBook> add_venue(SymbolId id, const VenueConfig& config);
+
+    SymbolId get_symbol_id(const std::string& symbol) const;
+    const std::string& get_symbol(SymbolId id) const;
+    std::shared_ptr<OrderBook> get_book(SymbolId id, const ExchangeName& exchange_name) const;
+    const std::vector<std::shared_ptr<OrderBook>>& get_books(SymbolId id) const;
+    size_t size() const;
+
+    SmartOrderRouter& get_router(SymbolId id);
+    ExecutionPlan distribute_order(SymbolId id, Volume order_size, OrderSide side,
+                                   RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                                   std::chrono::microseconds latency_budget = NO_LATENCY_BUDGET);
+};
+
+#endif // SYMBOLREGISTRY_H
@@ -0,0 +1,41 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for CPU-bound fan-out. parallel_for() lets the calling thread take
+// part in the work, so it completes even when every worker is busy (including nested calls).
+class ThreadPool 
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_task_ready;
+    bool m_stopping = false;
+
+    void worker_loop();
+
+public:
+    explicit ThreadPool(size_t worker_count);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool with one worker per hardware thread besides the caller's
+    static ThreadPool& shared();
+
+    size_t get_worker_count() const;
+    void submit(std::function<void()> task);
+
+    // Runs task(i) for every i in [0, count) and returns once all have finished
+    void parallel_for(size_t count, const std::function<void(size_t)>& task);
+};
+
+#endif // THREADPOOL_H
@@ -2,9 +2,20 @@
 #define UTILS_H
 
 #include "orderbook.h"
+#include <algorithm>
+#include <cstdio>
 #include <string>
 
-// Reads CSV data into an OrderBook
-void read_csv(const std::string& filename, OrderBook& order_book);
+// Reads CSV data into an OrderBook and returns the number of levels read
+size_t read_csv(const std::string& filename, OrderBook& order_book);
+
+// printf-style append of one short field group; output past the scratch size is cut off
+template <typename... Args>
+void append_format(std::string& out, const char* format, Args... args)
+{
+    char scratch[256];
+    int written = std::snprintf(scratch, sizeof(scratch), format, args...);
+    out.append(scratch, static_cast<size_t>(std::clamp<int>(written, 0, sizeof(scratch) - 1)));
+}
 
 #endif // UTILS_H
\ No newline at end of file
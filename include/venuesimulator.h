@@ -0,0 +1,143 @@
+#ifndef VENUESIMULATOR_H
+#define VENUESIMULATOR_H
+
+#include "executionplan.h"
+#include "orderbook.h"
+#include "smartorderrouter.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// In-process stand-ins for the venues: each simulator matches child orders against its own copy of a
+// book after a simulated network delay, so routing can be measured from market tick to fill report.
+
+struct VenueBehaviour
+{
+    std::chrono::microseconds latency{250};     // One-way delay, applied to the order and to its report
+    std::chrono::microseconds jitter{0};        // Extra exponential delay with this mean, per leg
+    double partial_fill_probability = 0.0;      // Chance that a child fills only part of the matched volume
+    double min_fill_ratio = 0.5;                // Lower bound of the uniform fraction filled then
+    double competition_probability = 0.0;       // Chance that other flow took the top level before arrival
+};
+
+// Immediate-or-cancel child order; it never trades through `limit_price`
+struct ChildOrder
+{
+    uint64_t id;
+    OrderSide side;
+    Price limit_price;
+    Volume volume;
+};
+
+struct ExecutionReport
+{
+    uint64_t child_id;
+    ExchangeName exchange_name;
+    Volume requested;
+    Volume filled;
+    Price average_price;        // Before fees, 0 when nothing filled
+    double fee_rate;
+    std::chrono::steady_clock::time_point sent;
+    std::chrono::steady_clock::time_point matched;     // When the venue matched the order
+    std::chrono::steady_clock::time_point received;    // When the report reached the router side
+};
+
+class VenueSimulator
+{
+private:
+    struct Event
+    {
+        std::chrono::steady_clock::time_point due;
+        uint64_t sequence;      // Keeps events with the same due time in submission order
+        std::function<void()> action;
+
+        bool operator>(const Event& other) const
+        {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    OrderBook m_book;
+    VenueBehaviour m_behaviour;
+    std::mt19937 m_rng;             // Outbound delays, guarded by m_mutex
+    std::mt19937 m_worker_rng;      // Matching and return delays, used only by m_worker
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events;
+    uint64_t m_sequence = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_event_ready;
+    bool m_stopping = false;
+    std::thread m_worker;
+
+    std::chrono::nanoseconds sample_latency(std::mt19937& rng) const;
+    void schedule(std::chrono::steady_clock::time_point due, std::function<void()> action);
+    void run();
+    // Applies competition and the partial-fill model, then sweeps the book up to the limit price
+    ExecutionReport match(const ChildOrder& order);
+
+public:
+    // Copies the routable levels of `book`; later changes to `book` are not seen by the venue
+    VenueSimulator(const OrderBook& book, VenueBehaviour behaviour, unsigned seed = 1);
+    ~VenueSimulator();
+    VenueSimulator(const VenueSimulator&) = delete;
+    VenueSimulator& operator=(const VenueSimulator&) = delete;
+
+    // `on_report` runs on the simulator's thread once the report has travelled back
+    void submit(const ChildOrder& order, std::function<void(const ExecutionReport&)> on_report);
+
+    const ExchangeName get_exchange_name() const;
+    // The venue's own book; read it only while no orders are in flight
+    const OrderBook& get_book() const;
+};
+
+struct RoundTrip
+{
+    ExecutionPlan plan;
+    std::vector<ExecutionReport> reports;   // In plan order
+    std::chrono::nanoseconds route_latency{0};          // Tick to plan ready
+    std::chrono::nanoseconds tick_to_first_fill{0};     // Tick to the first report with volume, 0 when none filled
+    std::chrono::nanoseconds tick_to_last_fill{0};      // Tick to the last report
+    Volume filled = 0.0;
+    Price executed_total = 0.0;     // Cost for BUY, proceeds for SELL, fees included
+    double slippage_bps = 0.0;      // Executed vs planned average effective price, positive when worse
+};
+
+struct LatencySummary
+{
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p90{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds max{0};
+};
+
+LatencySummary summarize_latencies(std::vector<std::chrono::nanoseconds> samples);
+
+// Routes parent orders with a router and sends every fill of the plan to the venue simulators
+class SimulationDriver
+{
+private:
+    SmartOrderRouter& m_router;
+    std::unordered_map<ExchangeName, VenueSimulator*> m_venues;
+    double m_limit_tolerance_bps = 0.0;
+    uint64_t m_next_child_id = 1;
+
+public:
+    // Every venue the router can route to needs a simulator
+    SimulationDriver(SmartOrderRouter& router, const std::vector<std::unique_ptr<VenueSimulator>>& venues);
+
+    // How far past the planned price child orders may trade, in basis points
+    void set_limit_tolerance(double bps);
+
+    // `tick` is when the market event that triggered the order was seen; defaults to the call time
+    RoundTrip execute(Volume order_size, OrderSide side, RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID,
+                      std::chrono::steady_clock::time_point tick = std::chrono::steady_clock::now());
+};
+
+#endif // VENUESIMULATOR_H
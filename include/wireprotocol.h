@@ -0,0 +1,79 @@
+#ifndef WIREPROTOCOL_H
+#define WIREPROTOCOL_H
+
+#include "executionplan.h"
+#include "smartorderrouter.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary framing used by RoutingServer. Every frame is a fixed 9-byte header followed by
+// payload_length bytes. Fields are written in host byte order: the server only listens on
+// Unix domain sockets and loopback TCP, so both ends always share the same machine.
+//
+//   header:      u32 payload_length | u32 request_id | u8 code (WireRequestType or WireStatus)
+//   order:       f64 size | u8 side | u8 algorithm | u64 latency_budget_us
+//   liquidity:   u8 side
+//   plan:        f64 total | f64 fees | f64 avg_price | u32 fill_count | fill_count x fill
+//   fill:        u8 name_length | name | f64 price | f64 volume
+//   venues:      u32 venue_count | venue_count x (u8 name_length | name | f64 best_price | f64 volume | u32 levels)
+//
+// Responses carry the request_id of their request, so clients may pipeline any number of requests.
+
+constexpr size_t WIRE_HEADER_SIZE = 9;
+constexpr uint32_t WIRE_MAX_PAYLOAD = 1 << 20;
+constexpr uint64_t WIRE_NO_LATENCY_BUDGET = UINT64_MAX;
+
+enum class WireRequestType : uint8_t
+{
+    DISTRIBUTE = 1,
+    QUOTE = 2,
+    LIQUIDITY = 3
+};
+
+enum class WireStatus : uint8_t
+{
+    OK = 0,
+    BAD_REQUEST = 1,
+    SERVER_ERROR = 2
+};
+
+struct WireHeader
+{
+    uint32_t payload_length;
+    uint32_t request_id;
+    uint8_t code;
+};
+
+struct WireOrderRequest
+{
+    Volume size;
+    OrderSide side;
+    RoutingAlgorithm algorithm;
+    uint64_t latency_budget_us = WIRE_NO_LATENCY_BUDGET;
+};
+
+struct WirePlan
+{
+    Price total = 0.0;
+    Price fees = 0.0;
+    Price average_price = 0.0;
+    std::vector<FillOrder> fills;
+};
+
+// Encoders append a complete frame to `out`
+void encode_order_request(std::string& out, uint32_t request_id, WireRequestType type, const WireOrderRequest& request);
+void encode_liquidity_request(std::string& out, uint32_t request_id, OrderSide side);
+void encode_plan_response(std::string& out, uint32_t request_id, const ExecutionPlan& plan);
+void encode_liquidity_response(std::string& out, uint32_t request_id, const std::vector<VenueLiquidity>& liquidity);
+void encode_error_response(std::string& out, uint32_t request_id, WireStatus status);
+
+// Decoders return false on malformed input
+bool decode_header(const char* data, size_t size, WireHeader& header);
+bool decode_order_request(const char* payload, size_t size, WireOrderRequest& request);
+bool decode_liquidity_request(const char* payload, size_t size, OrderSide& side);
+bool decode_plan_response(const char* payload, size_t size, WirePlan& plan);
+bool decode_liquidity_response(const char* payload, size_t size, std::vector<VenueLiquidity>& liquidity);
+
+#endif // WIREPROTOCOL_H
@@ -0,0 +1,238 @@
+#include "batchrunner.h"
+#include "netting.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr size_t OUTPUT_FLUSH_THRESHOLD = 1 << 16;
+
+struct BatchOrder
+{
+    Volume size = 0.0;
+    OrderSide side = OrderSide::BUY;
+    RoutingAlgorithm algorithm = RoutingAlgorithm::HYBRID;
+};
+
+std::string trim(const std::string& field)
+{
+    size_t begin = field.find_first_not_of(" \t\r");
+    size_t end = field.find_last_not_of(" \t\r");
+    return (begin == std::string::npos) ? "" : field.substr(begin, end - begin + 1);
+}
+
+std::string upper(std::string field)
+{
+    std::transform(field.begin(), field.end(), field.begin(), [](unsigned char c) { return std::toupper(c); });
+    return field;
+}
+
+bool parse_order(const std::string& line, BatchOrder& order)
+{
+    std::stringstream ss(line);
+    std::string size_str, side_str, algorithm_str;
+    std::getline(ss, size_str, ',');
+    std::getline(ss, side_str, ',');
+    std::getline(ss, algorithm_str, ',');
+
+    try 
+    {
+        size_t parsed = 0;
+        order.size = std::stod(trim(size_str), &parsed);
+        // stod also parses "nan" and "inf"
+        if (parsed != trim(size_str).size() || !(order.size > 0.0) || !std::isfinite(order.size)) return false;
+    } 
+    catch (...) 
+    {
+        return false;
+    }
+
+    side_str = upper(trim(side_str));
+    if (side_str == "BUY" || side_str == "B") order.side = OrderSide::BUY;
+    else if (side_str == "SELL" || side_str == "S") order.side = OrderSide::SELL;
+    else return false;
+
+    algorithm_str = upper(trim(algorithm_str));
+    if (algorithm_str.empty() || algorithm_str == "H" || algorithm_str == "HYBRID") order.algorithm = RoutingAlgorithm::HYBRID;
+    else if (algorithm_str == "G" || algorithm_str == "GREEDY" || algorithm_str == "PURE_GREEDY") order.algorithm = RoutingAlgorithm::PURE_GREEDY;
+    else if (algorithm_str == "A" || algorithm_str == "ADAPTIVE") order.algorithm = RoutingAlgorithm::ADAPTIVE;
+    else return false;
+
+    return true;
+}
+
+const char* side_name(OrderSide side)
+{
+    return side == OrderSide::BUY ? "BUY" : "SELL";
+}
+
+const char* algorithm_name(RoutingAlgorithm algorithm)
+{
+    if (algorithm == RoutingAlgorithm::ADAPTIVE) return "ADAPTIVE";
+    return algorithm == RoutingAlgorithm::HYBRID ? "HYBRID" : "GREEDY";
+}
+
+void write_plan(std::string& buffer, size_t order_id, const BatchOrder& order, const ExecutionPlan& plan,
+                double latency_us, BatchFormat format)
+{
+    if (format == BatchFormat::CSV) 
+    {
+        for (const FillOrder& fill : plan.get_plan()) 
+        {
+            append_format(buffer, "%zu,%s,%s,", order_id, side_name(order.side), algorithm_name(order.algorithm));
+            buffer += fill.exchange_name;
+            append_format(buffer, ",%.8f,%.8f\n", fill.price, fill.volume);
+        }
+        return;
+    }
+
+    // The plan object carries the side, metrics and fills; the batch-only fields go in front of them
+    append_format(buffer, "{\"id\":%zu,\"algorithm\":\"%s\",\"latency_us\":%.3f,", order_id, algorithm_name(order.algorithm),
+                  latency_us);
+    size_t plan_start = buffer.size();
+    plan.append_json(buffer);
+    buffer.erase(plan_start, 1);
+    buffer += '\n';
+}
+
+double percentile(std::vector<double>& sorted_values, double fraction)
+{
+    if (sorted_values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted_values.size() - 1) + 0.5);
+    return sorted_values[index];
+}
+}
+
+BatchSummary run_batch(SmartOrderRouter& router, std::istream& input, std::ostream& output, BatchFormat format,
+                       PlanJournal* journal, size_t netting_window)
+{
+    BatchSummary summary;
+    summary.netting_window = netting_window;
+    std::vector<double> latencies_us;
+    std::string buffer;
+    buffer.reserve(OUTPUT_FLUSH_THRESHOLD * 2);
+    std::vector<BatchOrder> window;
+    std::vector<ParentOrder> parents;
+
+    auto write_buffer = [&](bool flush)
+    {
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+        if (flush) output.flush();
+    };
+
+    auto emit = [&](const BatchOrder& order, const ExecutionPlan& plan, double latency_us)
+    {
+        if (journal) journal->record(plan);
+        summary.fills += plan.get_plan().size();
+        write_plan(buffer, ++summary.orders, order, plan, latency_us, format);
+
+        if (buffer.size() >= OUTPUT_FLUSH_THRESHOLD) write_buffer(false);
+    };
+
+    auto flush_window = [&]()
+    {
+        if (window.empty()) return;
+        parents.clear();
+        for (const BatchOrder& order : window) 
+        {
+            parents.push_back({order.size, order.side, order.algorithm});
+        }
+        auto start = std::chrono::steady_clock::now();
+        NettingResult netted = net_and_route(router, parents);
+        double latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        // One sample per window: repeating it for every parent would weight each window by its size
+        latencies_us.push_back(latency_us);
+        summary.routing_calls += netted.routing_calls;
+        summary.netted_volume += netted.crossed_volume;
+        for (size_t i = 0; i < window.size(); ++i) 
+        {
+            emit(window[i], netted.plans[i], latency_us);
+        }
+        window.clear();
+    };
+
+    if (format == BatchFormat::CSV) 
+    {
+        buffer += "order_id,side,algorithm,exchange,price,volume\n";
+    }
+
+    auto batch_start = std::chrono::steady_clock::now();
+    std::string line;
+    bool first_line = true;
+    while (true) 
+    {
+        // A live producer may wait for these plans before it sends more, so they go out before
+        // reading would block, together with a partial netting window; a file or a busy pipe still
+        // has input buffered and keeps batching
+        if (input.rdbuf()->in_avail() <= 0) 
+        {
+            flush_window();
+            if (!buffer.empty()) write_buffer(true);
+        }
+        if (!std::getline(input, line)) break;
+
+        std::string trimmed = trim(line);
+        bool header_candidate = first_line;
+        first_line = false;
+        if (trimmed.empty() || trimmed[0] == '#') continue;
+
+        BatchOrder order;
+        if (!parse_order(trimmed, order)) 
+        {
+            // A leading non-numeric line is a column header, not a bad order
+            if (!(header_candidate && !std::isdigit(static_cast<unsigned char>(trimmed[0])) && trimmed[0] != '.')) 
+            {
+                ++summary.rejected;
+            }
+            continue;
+        }
+
+        if (netting_window > 0) 
+        {
+            window.push_back(order);
+            if (window.size() == netting_window) flush_window();
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ExecutionPlan plan = router.distribute_order(order.size, order.side, order.algorithm);
+        double latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        ++summary.routing_calls;
+        latencies_us.push_back(latency_us);
+        emit(order, plan, latency_us);
+    }
+    flush_window();
+    write_buffer(true);
+
+    summary.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+    std::sort(latencies_us.begin(), latencies_us.end());
+    summary.latency_p50_us = percentile(latencies_us, 0.50);
+    summary.latency_p99_us = percentile(latencies_us, 0.99);
+    summary.latency_max_us = latencies_us.empty() ? 0.0 : latencies_us.back();
+    return summary;
+}
+
+void print_batch_summary(const BatchSummary& summary, std::ostream& output)
+{
+    char line[320];
+    char sampling[64] = "per order";
+    if (summary.netting_window > 0) 
+    {
+        std::snprintf(sampling, sizeof(sampling), "per netting window of %zu orders", summary.netting_window);
+    }
+    std::snprintf(line, sizeof(line),
+                  "Orders: %zu, Rejected: %zu, Fills: %zu, Elapsed: %.3f s, Throughput: %.0f orders/s\n"
+                  "Routing latency (us, %s): p50 %.2f, p99 %.2f, max %.2f\n"
+                  "Routing calls: %zu, Netted volume: %.8f\n",
+                  summary.orders, summary.rejected, summary.fills, summary.elapsed_seconds, summary.orders_per_second(),
+                  sampling, summary.latency_p50_us, summary.latency_p99_us, summary.latency_max_us,
+                  summary.routing_calls, summary.netted_volume);
+    output << line;
+}
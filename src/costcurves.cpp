@@ -0,0 +1,172 @@
+#include "costcurves.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+constexpr double VOLUME_TICK = 1e-6;    // Same resolution as the router's EPSILON
+constexpr size_t MERGE_CHUNK = 256;     // Output cells per parallel task
+constexpr size_t DEADLINE_CHECK_CELLS = 64;     // One merge cell can scan the whole grid
+constexpr Price UNREACHABLE = std::numeric_limits<Price>::infinity();
+
+struct CurveNode
+{
+    std::vector<Price> cost;        // Cheapest cost of exactly w grid units, UNREACHABLE if impossible
+    std::vector<size_t> support;    // Reachable w in ascending order
+    std::vector<size_t> split;      // Merged nodes: units taken from the left child for each w
+    size_t left = 0;
+    size_t right = 0;
+    size_t venue = 0;               // Leaves only
+    bool leaf = true;
+};
+}
+
+bool solve_cost_curves(const std::vector<VenueCostCurve>& curves, Volume capacity, ThreadPool* pool,
+                       std::chrono::steady_clock::time_point deadline, CostCurveSolution& solution)
+{
+    // Express every lot size in ticks and find the coarsest grid they all sit on
+    std::vector<long long> lot_ticks(curves.size());
+    long long grid = 0;
+    for (size_t v = 0; v < curves.size(); ++v) 
+    {
+        lot_ticks[v] = std::llround(curves[v].lot_size / VOLUME_TICK);
+        if (lot_ticks[v] <= 0 || std::abs(lot_ticks[v] * VOLUME_TICK - curves[v].lot_size) > VOLUME_TICK * 1e-3) return false;
+        grid = std::gcd(grid, lot_ticks[v]);
+    }
+    if (curves.empty()) 
+    {
+        solution = CostCurveSolution();
+        return true;
+    }
+
+    // Same admissibility as the branch and bound: a plan may exceed capacity by at most one tick
+    double capacity_ticks = std::floor(capacity / VOLUME_TICK + 1.0 + 1e-6);
+    if (capacity_ticks < 0 || capacity_ticks / grid > MAX_COST_CURVE_GRID) return false;
+    const size_t width = static_cast<size_t>(capacity_ticks) / static_cast<size_t>(grid);
+
+    std::vector<CurveNode> nodes(curves.size());
+    std::vector<size_t> level(curves.size());
+    for (size_t v = 0; v < curves.size(); ++v) 
+    {
+        CurveNode& node = nodes[v];
+        size_t units = static_cast<size_t>(lot_ticks[v] / grid);
+        node.venue = v;
+        node.cost.assign(width + 1, UNREACHABLE);
+        for (size_t k = 0; k < curves[v].cumulative_cost.size() && k * units <= width; ++k) 
+        {
+            node.cost[k * units] = curves[v].cumulative_cost[k];
+            node.support.push_back(k * units);
+        }
+        level[v] = v;
+    }
+
+    auto run = [pool](size_t count, const std::function<void(size_t)>& task) 
+    {
+        if (pool && pool->get_worker_count() > 0 && count > 1) 
+        {
+            pool->parallel_for(count, task);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) task(i);
+    };
+
+    const size_t chunks = (width + MERGE_CHUNK) / MERGE_CHUNK;
+    // A single level can outlast the budget on a wide grid, so the chunk tasks watch the deadline too
+    std::atomic<bool> expired{false};
+    while (level.size() > 1) 
+    {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+
+        // Pair neighbours; an odd node out is carried to the next level unchanged
+        std::vector<size_t> next_level;
+        std::vector<size_t> merges;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) 
+        {
+            CurveNode node;
+            node.leaf = false;
+            node.left = level[i];
+            node.right = level[i + 1];
+            node.cost.assign(width + 1, UNREACHABLE);
+            node.split.assign(width + 1, 0);
+            merges.push_back(nodes.size());
+            next_level.push_back(nodes.size());
+            nodes.push_back(std::move(node));
+        }
+        if (level.size() % 2 == 1) next_level.push_back(level.back());
+
+        run(merges.size() * chunks, [&](size_t task) 
+        {
+            CurveNode& node = nodes[merges[task / chunks]];
+            const CurveNode& left = nodes[node.left];
+            const CurveNode& right = nodes[node.right];
+            size_t begin = (task % chunks) * MERGE_CHUNK;
+            size_t end = std::min(width + 1, begin + MERGE_CHUNK);
+            for (size_t w = begin; w < end; ++w) 
+            {
+                if ((w - begin) % DEADLINE_CHECK_CELLS == 0) 
+                {
+                    if (expired.load(std::memory_order_relaxed)) return;
+                    if (std::chrono::steady_clock::now() >= deadline) 
+                    {
+                        expired.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+                Price best = UNREACHABLE;
+                size_t best_split = 0;
+                for (size_t a : left.support) 
+                {
+                    if (a > w) break;
+                    Price cost = left.cost[a] + right.cost[w - a];
+                    if (cost < best) 
+                    {
+                        best = cost;
+                        best_split = a;
+                    }
+                }
+                node.cost[w] = best;
+                node.split[w] = best_split;
+            }
+        });
+        if (expired.load(std::memory_order_relaxed)) return false;
+
+        for (size_t index : merges) 
+        {
+            CurveNode& node = nodes[index];
+            for (size_t w = 0; w <= width; ++w) 
+            {
+                if (node.cost[w] != UNREACHABLE) node.support.push_back(w);
+            }
+            // Children are no longer needed once merged
+            std::vector<Price>().swap(nodes[node.left].cost);
+            std::vector<Price>().swap(nodes[node.right].cost);
+        }
+        level = std::move(next_level);
+    }
+
+    // Largest reachable volume first; the root already holds its cheapest cost
+    const CurveNode& root = nodes[level.front()];
+    size_t filled = root.support.back();
+    CostCurveSolution result;
+    result.cost = root.cost[filled];
+    result.lots_per_venue.assign(curves.size(), 0);
+
+    std::vector<std::pair<size_t, size_t>> pending{{level.front(), filled}};
+    while (!pending.empty()) 
+    {
+        auto [index, units] = pending.back();
+        pending.pop_back();
+        const CurveNode& node = nodes[index];
+        if (node.leaf) 
+        {
+            result.lots_per_venue[node.venue] = units / static_cast<size_t>(lot_ticks[node.venue] / grid);
+            continue;
+        }
+        pending.emplace_back(node.left, node.split[units]);
+        pending.emplace_back(node.right, units - node.split[units]);
+    }
+    solution = std::move(result);
+    return true;
+}
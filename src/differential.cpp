@@ -0,0 +1,344 @@
+#include "differential.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+constexpr double EPSILON = 1e-6;
+constexpr double COST_TOLERANCE = 1e-6;
+
+using Levels = std::vector<std::pair<Price, Volume>>;
+
+double round_to(double value, double step)
+{
+    return std::round(value / step) * step;
+}
+
+// Levels on the side an order of `side` consumes, best price first
+Levels priority_levels(const DifferentialVenue& venue, OrderSide side)
+{
+    Levels levels = (side == OrderSide::BUY) ? venue.asks : venue.bids;
+    std::sort(levels.begin(), levels.end(), [side](const auto& a, const auto& b)
+    {
+        return side == OrderSide::BUY ? a.first < b.first : a.first > b.first;
+    });
+    return levels;
+}
+
+bool is_better(Volume volume_a, Price cost_a, Volume volume_b, Price cost_b)
+{
+    return volume_a > volume_b + EPSILON ||
+           (std::abs(volume_a - volume_b) <= EPSILON && cost_a < cost_b - COST_TOLERANCE);
+}
+
+DifferentialOutcome route(const SmartOrderRouter& router, const DifferentialCase& test_case, RoutingAlgorithm algorithm)
+{
+    auto start = std::chrono::steady_clock::now();
+    ExecutionPlan plan = router.quote(test_case.order_size, test_case.side, algorithm);
+    DifferentialOutcome outcome;
+    outcome.latency = std::chrono::steady_clock::now() - start;
+    for (const FillOrder& fill : plan.get_plan())
+    {
+        outcome.volume += fill.volume;
+    }
+    outcome.cost = (test_case.side == OrderSide::BUY) ? plan.get_total() : -plan.get_total();
+    return outcome;
+}
+
+Levels& consumed_levels(DifferentialCase& test_case, size_t venue)
+{
+    return (test_case.side == OrderSide::BUY) ? test_case.venues[venue].asks : test_case.venues[venue].bids;
+}
+
+std::string book_file_name(const ExchangeName& exchange_name)
+{
+    std::string name = exchange_name;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    return name + "_order_book.csv";
+}
+}
+
+DifferentialShape default_differential_shape()
+{
+    DifferentialShape shape;
+    shape.venues = {{"Binance", 0.001, 0.1}, {"KuCoin", 0.0005, 0.15}, {"OKX", 0.0002, 0.2}};
+    return shape;
+}
+
+DifferentialCase generate_case(const DifferentialShape& shape, std::mt19937& rng)
+{
+    std::uniform_int_distribution<size_t> level_count(1, shape.max_levels);
+    std::uniform_int_distribution<int> gap_ticks(1, 3);
+    std::uniform_real_distribution<double> level_volume(0.01, shape.max_level_volume);
+    std::uniform_real_distribution<double> order_size(0.05, shape.max_order_size);
+
+    DifferentialCase test_case;
+    for (const VenueConfig& config : shape.venues)
+    {
+        DifferentialVenue venue{config, {}, {}};
+        int bid_ticks = 0;
+        int ask_ticks = 0;
+        for (size_t level = 0, count = level_count(rng); level < count; ++level)
+        {
+            bid_ticks += gap_ticks(rng);
+            venue.bids.emplace_back(round_to(shape.mid_price - bid_ticks * shape.tick, shape.tick), round_to(level_volume(rng), 1e-4));
+        }
+        for (size_t level = 0, count = level_count(rng); level < count; ++level)
+        {
+            ask_ticks += gap_ticks(rng);
+            venue.asks.emplace_back(round_to(shape.mid_price + ask_ticks * shape.tick, shape.tick), round_to(level_volume(rng), 1e-4));
+        }
+        test_case.venues.push_back(std::move(venue));
+    }
+    test_case.order_size = round_to(order_size(rng), 0.01);
+    test_case.side = (rng() % 2 == 0) ? OrderSide::BUY : OrderSide::SELL;
+    return test_case;
+}
+
+SmartOrderRouter build_router(const DifferentialCase& test_case)
+{
+    std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>> order_books;
+    for (const DifferentialVenue& venue : test_case.venues)
+    {
+        auto book = std::make_shared<OrderBook>(venue.config.exchange_name, venue.config.taker_fee, venue.config.min_order_size);
+        for (const auto& [price, volume] : venue.bids) book->add_bid(price, volume);
+        for (const auto& [price, volume] : venue.asks) book->add_ask(price, volume);
+        order_books.emplace(venue.config.exchange_name, std::move(book));
+    }
+    return SmartOrderRouter(std::move(order_books));
+}
+
+DifferentialOutcome solve_reference(const DifferentialCase& test_case)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Every lot of a venue has the venue's min order size, so of all plans taking k lots there the
+    // k best-priced ones are cheapest. Enumerating k per venue therefore covers every plan.
+    struct VenueLots
+    {
+        Volume lot_size;
+        std::vector<Price> prefix_cost;     // Signed cost of the k best lots
+    };
+    std::vector<VenueLots> venues;
+    for (const DifferentialVenue& venue : test_case.venues)
+    {
+        Volume lot_size = venue.config.min_order_size;
+        size_t max_lots = static_cast<size_t>(std::floor(test_case.order_size / lot_size + EPSILON));
+        VenueLots lots{lot_size, {0.0}};
+        for (const auto& [price, volume] : priority_levels(venue, test_case.side))
+        {
+            Price unit_cost = (test_case.side == OrderSide::BUY) ? price * (1 + venue.config.taker_fee)
+                                                                 : -price * (1 - venue.config.taker_fee);
+            size_t level_lots = static_cast<size_t>(std::floor(volume / lot_size + EPSILON));
+            for (size_t lot = 0; lot < level_lots && lots.prefix_cost.size() <= max_lots; ++lot)
+            {
+                lots.prefix_cost.push_back(lots.prefix_cost.back() + lot_size * unit_cost);
+            }
+        }
+        venues.push_back(std::move(lots));
+    }
+
+    DifferentialOutcome best;
+    std::function<void(size_t, Volume, Price)> enumerate = [&](size_t venue, Volume volume, Price cost)
+    {
+        if (venue == venues.size())
+        {
+            if (is_better(volume, cost, best.volume, best.cost))
+            {
+                best.volume = volume;
+                best.cost = cost;
+            }
+            return;
+        }
+        const VenueLots& lots = venues[venue];
+        for (size_t k = 0; k < lots.prefix_cost.size(); ++k)
+        {
+            Volume taken = volume + k * lots.lot_size;
+            if (taken > test_case.order_size + EPSILON) break;
+            enumerate(venue + 1, taken, cost + lots.prefix_cost[k]);
+        }
+    };
+    enumerate(0, 0.0, 0.0);
+
+    best.latency = std::chrono::steady_clock::now() - start;
+    return best;
+}
+
+DifferentialResult run_differential(const DifferentialCase& test_case)
+{
+    SmartOrderRouter router = build_router(test_case);
+    DifferentialResult result;
+    result.greedy = route(router, test_case, RoutingAlgorithm::PURE_GREEDY);
+    result.hybrid = route(router, test_case, RoutingAlgorithm::HYBRID);
+    result.reference = solve_reference(test_case);
+    return result;
+}
+
+Price get_cost_gap(const DifferentialResult& result, RoutingAlgorithm algorithm)
+{
+    return result.get(algorithm).cost - result.reference.cost;
+}
+
+Volume get_fulfillment_gap(const DifferentialResult& result, RoutingAlgorithm algorithm)
+{
+    return result.reference.volume - result.get(algorithm).volume;
+}
+
+bool diverges(const DifferentialResult& result, RoutingAlgorithm algorithm)
+{
+    // Beating the reference counts too: it means an overfill or a reference bug
+    Volume fulfillment_gap = get_fulfillment_gap(result, algorithm);
+    if (std::abs(fulfillment_gap) > EPSILON) return true;
+    return std::abs(get_cost_gap(result, algorithm)) > COST_TOLERANCE;
+}
+
+DifferentialCase minimize_case(const DifferentialCase& test_case, RoutingAlgorithm algorithm)
+{
+    auto still_diverges = [algorithm](const DifferentialCase& candidate)
+    {
+        return diverges(run_differential(candidate), algorithm);
+    };
+
+    DifferentialCase current = test_case;
+    // The side the order does not consume never matters
+    for (DifferentialVenue& venue : current.venues)
+    {
+        (current.side == OrderSide::BUY ? venue.bids : venue.asks).clear();
+    }
+    if (!still_diverges(current)) return test_case;
+
+    bool reduced = true;
+    while (reduced)
+    {
+        reduced = false;
+
+        for (size_t venue = 0; venue < current.venues.size() && current.venues.size() > 1; ++venue)
+        {
+            DifferentialCase candidate = current;
+            candidate.venues.erase(candidate.venues.begin() + venue);
+            if (still_diverges(candidate))
+            {
+                current = std::move(candidate);
+                reduced = true;
+                --venue;
+            }
+        }
+
+        for (size_t venue = 0; venue < current.venues.size(); ++venue)
+        {
+            Volume lot_size = current.venues[venue].config.min_order_size;
+            for (size_t level = 0; level < consumed_levels(current, venue).size(); ++level)
+            {
+                DifferentialCase candidate = current;
+                Levels& candidate_levels = consumed_levels(candidate, venue);
+                candidate_levels.erase(candidate_levels.begin() + level);
+                if (still_diverges(candidate))
+                {
+                    current = std::move(candidate);
+                    reduced = true;
+                    --level;
+                    continue;
+                }
+
+                // Shrink the level by one lot, then to a whole number of lots
+                for (int attempt = 0; attempt < 2; ++attempt)
+                {
+                    Volume volume = consumed_levels(current, venue)[level].second;
+                    Volume shrunk = (attempt == 0) ? volume - lot_size : std::floor(volume / lot_size + EPSILON) * lot_size;
+                    if (shrunk < lot_size - EPSILON || std::abs(shrunk - volume) <= EPSILON) continue;
+                    candidate = current;
+                    consumed_levels(candidate, venue)[level].second = round_to(shrunk, 1e-8);
+                    if (still_diverges(candidate))
+                    {
+                        current = std::move(candidate);
+                        reduced = true;
+                    }
+                }
+            }
+        }
+
+        for (const DifferentialVenue& venue : current.venues)
+        {
+            DifferentialCase candidate = current;
+            candidate.order_size = round_to(current.order_size - venue.config.min_order_size, 1e-8);
+            if (candidate.order_size > EPSILON && still_diverges(candidate))
+            {
+                current = std::move(candidate);
+                reduced = true;
+                break;
+            }
+        }
+    }
+    return current;
+}
+
+void save_case(const DifferentialCase& test_case, const std::string& directory)
+{
+    std::filesystem::path path(directory);
+    std::filesystem::create_directories(path);
+
+    std::ofstream venues(path / "venues.csv");
+    venues << "Exchange,TakerFee,MinOrderSize" << std::endl;
+    for (const DifferentialVenue& venue : test_case.venues)
+    {
+        venues << venue.config.exchange_name << "," << venue.config.taker_fee << "," << venue.config.min_order_size << std::endl;
+
+        std::ofstream book(path / book_file_name(venue.config.exchange_name));
+        book << std::fixed << std::setprecision(8) << "Price,Quantity,Type" << std::endl;
+        for (const auto& [price, volume] : venue.bids) book << price << "," << volume << ",Bid" << std::endl;
+        for (const auto& [price, volume] : venue.asks) book << price << "," << volume << ",Ask" << std::endl;
+    }
+
+    std::ofstream order(path / "order.csv");
+    order << std::setprecision(10) << "Size,Side" << std::endl;
+    order << test_case.order_size << "," << (test_case.side == OrderSide::BUY ? "BUY" : "SELL") << std::endl;
+}
+
+DifferentialCase load_case(const std::string& directory)
+{
+    std::filesystem::path path(directory);
+    std::ifstream venues(path / "venues.csv");
+    std::ifstream order(path / "order.csv");
+    if (!venues.is_open() || !order.is_open())
+    {
+        throw std::runtime_error("Differential case not found in " + directory);
+    }
+
+    DifferentialCase test_case;
+    std::string line;
+    std::getline(venues, line); // Skip the header row
+    while (std::getline(venues, line))
+    {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        std::string name, fee, min_size;
+        std::getline(ss, name, ',');
+        std::getline(ss, fee, ',');
+        std::getline(ss, min_size, ',');
+
+        DifferentialVenue venue{{name, std::stod(fee), std::stod(min_size)}, {}, {}};
+        OrderBook book(name, venue.config.taker_fee, venue.config.min_order_size);
+        read_csv((path / book_file_name(name)).string(), book);
+        for (const auto& [price, level] : book.get_bids()) venue.bids.emplace_back(price, level.load());
+        for (const auto& [price, level] : book.get_asks()) venue.asks.emplace_back(price, level.load());
+        test_case.venues.push_back(std::move(venue));
+    }
+
+    std::getline(order, line); // Skip the header row
+    std::getline(order, line);
+    std::stringstream ss(line);
+    std::string size, side;
+    std::getline(ss, size, ',');
+    std::getline(ss, side, ',');
+    test_case.order_size = std::stod(size);
+    test_case.side = (side == "SELL") ? OrderSide::SELL : OrderSide::BUY;
+    return test_case;
+}
@@ -0,0 +1,290 @@
+#include "eventlog.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+// Long enough that the consumer rarely preempts routing, short enough that rings drain between bursts
+constexpr auto CONSUMER_IDLE_SLEEP = std::chrono::milliseconds(1);
+constexpr auto FLUSH_POLL = std::chrono::microseconds(50);
+
+const char* level_name(LogLevel level)
+{
+    switch (level) 
+    {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::OFF: break;
+    }
+    return "";
+}
+}
+
+#ifdef DEBUG_MODE
+std::atomic<uint8_t> EventLog::s_level{static_cast<uint8_t>(LogLevel::DEBUG)};
+#else
+std::atomic<uint8_t> EventLog::s_level{static_cast<uint8_t>(LogLevel::WARNING)};
+#endif
+
+EventLog::ThreadBufferOwner::~ThreadBufferOwner()
+{
+    if (buffer) buffer->retired.store(true, std::memory_order_release);
+}
+
+EventLog& EventLog::instance()
+{
+    static EventLog log;
+    return log;
+}
+
+EventLog::EventLog()
+    : m_output(&std::cerr), m_start(std::chrono::steady_clock::now())
+{
+    m_consumer = std::thread(&EventLog::consumer_loop, this);
+}
+
+EventLog::~EventLog()
+{
+    m_running.store(false, std::memory_order_release);
+    m_consumer.join();
+}
+
+void EventLog::set_level(LogLevel level)
+{
+    s_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel EventLog::get_level()
+{
+    return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed));
+}
+
+LogLevel EventLog::parse_level(const std::string& name)
+{
+    if (name == "trace") return LogLevel::TRACE;
+    if (name == "debug") return LogLevel::DEBUG;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "warning") return LogLevel::WARNING;
+    if (name == "error") return LogLevel::ERROR;
+    if (name == "off") return LogLevel::OFF;
+    throw std::invalid_argument("Unknown log level: " + name);
+}
+
+uint16_t EventLog::register_format(LogLevel level, const char* format)
+{
+    EventLog& log = instance();
+    std::lock_guard<std::mutex> lock(log.m_format_mutex);
+    size_t id = log.m_format_count.load(std::memory_order_relaxed);
+    // Out of ids: events are still recorded but skipped like padding
+    if (id == MAX_FORMATS) return PADDING_FORMAT;
+    log.m_formats[id] = {level, format};
+    log.m_format_count.store(id + 1, std::memory_order_release);
+    return static_cast<uint16_t>(id);
+}
+
+EventLog::ThreadBuffer& EventLog::get_thread_buffer()
+{
+    thread_local ThreadBufferOwner owner;
+    if (!owner.buffer) 
+    {
+        owner.buffer = std::make_shared<ThreadBuffer>();
+        owner.buffer->data.reset(new char[BUFFER_SIZE]);
+        std::lock_guard<std::mutex> lock(m_buffers_mutex);
+        owner.buffer->thread_index = m_next_thread_index++;
+        m_buffers.push_back(owner.buffer);
+    }
+    return *owner.buffer;
+}
+
+char* EventLog::reserve(ThreadBuffer& buffer, size_t size)
+{
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    uint64_t free_bytes = BUFFER_SIZE - (head - buffer.tail.load(std::memory_order_acquire));
+    size_t position = head & (BUFFER_SIZE - 1);
+    size_t contiguous = BUFFER_SIZE - position;
+    size_t needed = (size <= contiguous) ? size : contiguous + size;
+    if (needed > free_bytes) 
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Records never straddle the end of the ring: pad out the tail and start over at offset 0
+    if (size > contiguous) 
+    {
+        RecordHeader padding{static_cast<uint32_t>(contiguous), PADDING_FORMAT, 0, 0, 0};
+        std::memcpy(buffer.data.get() + position, &padding, sizeof(uint64_t));
+        buffer.head.store(head + contiguous, std::memory_order_release);
+        position = 0;
+    }
+    return buffer.data.get() + position;
+}
+
+void EventLog::format_record(const RecordHeader& header, uint32_t thread_index, const char* args, std::string& line) const
+{
+    const Format& format = m_formats[header.format_id];
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "[%lld] T%u ", static_cast<long long>(header.timestamp_ns / 1000), thread_index);
+    line += prefix;
+    line += level_name(format.level);
+    line += ' ';
+
+    uint8_t remaining = header.arg_count;
+    for (const char* text = format.text; *text; ++text) 
+    {
+        if (text[0] != '{' || text[1] != '}' || remaining == 0) 
+        {
+            line += *text;
+            continue;
+        }
+        ++text;
+        --remaining;
+
+        ArgType type = static_cast<ArgType>(*args++);
+        char value[32];
+        switch (type) 
+        {
+            case ArgType::INTEGER:
+            {
+                int64_t integer;
+                std::memcpy(&integer, args, sizeof(integer));
+                args += sizeof(integer);
+                std::snprintf(value, sizeof(value), "%lld", static_cast<long long>(integer));
+                line += value;
+                break;
+            }
+            case ArgType::UNSIGNED:
+            {
+                uint64_t integer;
+                std::memcpy(&integer, args, sizeof(integer));
+                args += sizeof(integer);
+                std::snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(integer));
+                line += value;
+                break;
+            }
+            case ArgType::REAL:
+            {
+                double real;
+                std::memcpy(&real, args, sizeof(real));
+                args += sizeof(real);
+                std::snprintf(value, sizeof(value), "%.10g", real);
+                line += value;
+                break;
+            }
+            case ArgType::STRING:
+            {
+                size_t length = static_cast<unsigned char>(*args++);
+                line.append(args, length);
+                args += length;
+                break;
+            }
+        }
+    }
+    line += '\n';
+}
+
+bool EventLog::drain()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_buffers_mutex);
+        buffers = m_buffers;
+    }
+
+    bool drained_any = false;
+    std::string text;
+
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_dropped_reported) 
+    {
+        char line[96];
+        std::snprintf(line, sizeof(line), "[%lld] WARNING %llu log events dropped (ring full)\n",
+                      static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count()),
+                      static_cast<unsigned long long>(dropped - m_dropped_reported));
+        m_dropped_reported = dropped;
+        std::lock_guard<std::mutex> lock(m_output_mutex);
+        *m_output << line;
+    }
+    for (const auto& buffer : buffers) 
+    {
+        // Read retired before head: once retired is seen, head is final
+        bool retired = buffer->retired.load(std::memory_order_acquire);
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (tail == head) 
+        {
+            if (retired) 
+            {
+                std::lock_guard<std::mutex> lock(m_buffers_mutex);
+                m_buffers.erase(std::find(m_buffers.begin(), m_buffers.end(), buffer));
+            }
+            continue;
+        }
+
+        text.clear();
+        while (tail != head) 
+        {
+            const char* record = buffer->data.get() + (tail & (BUFFER_SIZE - 1));
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(uint64_t));
+            if (header.format_id != PADDING_FORMAT) 
+            {
+                std::memcpy(&header, record, sizeof(header));
+                format_record(header, buffer->thread_index, record + sizeof(header), text);
+            }
+            tail += header.size;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_output_mutex);
+            m_output->write(text.data(), static_cast<std::streamsize>(text.size()));
+            m_output->flush();
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+        drained_any = true;
+    }
+    return drained_any;
+}
+
+void EventLog::consumer_loop()
+{
+    while (m_running.load(std::memory_order_acquire)) 
+    {
+        if (!drain()) std::this_thread::sleep_for(CONSUMER_IDLE_SLEEP);
+    }
+    drain();
+}
+
+void EventLog::set_output(std::ostream& output)
+{
+    std::lock_guard<std::mutex> lock(m_output_mutex);
+    m_output = &output;
+}
+
+void EventLog::flush()
+{
+    std::vector<std::pair<std::shared_ptr<ThreadBuffer>, uint64_t>> targets;
+    {
+        std::lock_guard<std::mutex> lock(m_buffers_mutex);
+        for (const auto& buffer : m_buffers) 
+        {
+            targets.emplace_back(buffer, buffer->head.load(std::memory_order_acquire));
+        }
+    }
+    for (const auto& [buffer, head] : targets) 
+    {
+        while (buffer->tail.load(std::memory_order_acquire) < head) 
+        {
+            std::this_thread::sleep_for(FLUSH_POLL);
+        }
+    }
+}
+
+uint64_t EventLog::get_dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
@@ -1,10 +1,46 @@
 #include "executionplan.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
-ExecutionPlan::ExecutionPlan(const std::vector<FillOrder>& plan,
-                            std::shared_ptr<const std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>>> order_books,
-                            OrderSide side,
-                            Volume original_order_size
-) : m_plan(plan), m_order_books(std::move(order_books)), m_side(side), m_original_order_size(original_order_size) {}
+namespace
+{
+template <typename T>
+void put(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool get(const char* data, size_t size, size_t& offset, T& value)
+{
+    if (size - offset < sizeof(T)) return false;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+void append_json_string(std::string& out, const std::string& value)
+{
+    out += '"';
+    for (char c : value) 
+    {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) 
+        {
+            append_format(out, "\\u%04x", static_cast<unsigned>(c));
+            continue;
+        }
+        out += c;
+    }
+    out += '"';
+}
+}
+
+ExecutionPlan::ExecutionPlan(OrderSide side, Volume original_order_size)
+    : m_side(side), m_original_order_size(original_order_size) {}
 
 const std::vector<FillOrder>& ExecutionPlan::get_plan() const 
 {
@@ -13,51 +49,31 @@ const std::vector<FillOrder>& ExecutionPlan::get_plan() const
 
 void ExecutionPlan::add_fill(FillOrder fill)
 {
-    m_plan.emplace_back(fill);
+    fill.effective_price = (m_side == OrderSide::BUY) ? fill.price * (1 + fill.fee_rate) : fill.price * (1 - fill.fee_rate);
+    m_filled_volume += fill.volume;
+    m_total += fill.volume * fill.effective_price;
+    m_total_fees += fill.volume * fill.price * fill.fee_rate;
+    m_plan.emplace_back(std::move(fill));
 }
 
 Price ExecutionPlan::get_total_fees() const 
 {
-    double total_fees = 0.0;
-    for (const auto& record : m_plan) 
-    {
-        const ExchangeName& exchange_name = record.exchange_name;
-        Price price = record.price;
-        Volume quantity = record.volume;
-        double fee = m_order_books->at(exchange_name)->get_taker_fee();
-        total_fees += quantity * price * fee;
-    }
-    return total_fees;
+    return m_total_fees;
 }
 
 // Get total cost (for buy orders) or total profit (for sell orders)
 Price ExecutionPlan::get_total() const 
 {
-    Price total = 0.0;
-    for (const FillOrder& record : m_plan) 
-    {
-        const ExchangeName& exchange_name = record.exchange_name;
-        Price price = record.price;
-        Volume quantity = record.volume;
-        double fee = m_order_books->at(exchange_name)->get_taker_fee();
-        Price effective_price = (m_side == OrderSide::BUY) ? price * (1 + fee) : price * (1 - fee);
-        total += quantity * effective_price;
-    }
-    return total;
+    return m_total;
 }
 
 Price ExecutionPlan::get_average_effective_price() const 
 {
-    Volume total_quantity = 0.0;
-    for (const FillOrder& record : m_plan) 
-    {
-        total_quantity += record.volume;
-    }
-    if (total_quantity == 0.0) 
+    if (m_filled_volume == 0.0) 
     {
         return 0.0;
     }
-    return get_total() / total_quantity;
+    return m_total / m_filled_volume;
 }
 
 double ExecutionPlan::get_fulfillment_percentage() const 
@@ -66,15 +82,65 @@ double ExecutionPlan::get_fulfillment_percentage() const
     {
         return 100.0;
     }
-    else
-    {
-        Volume total_quantity = 0.0;
-        for (const auto& record : m_plan) 
-        {
-            total_quantity += record.volume;
-        }
-        return (total_quantity / m_original_order_size) * 100.0;
-    }
+    return (m_filled_volume / m_original_order_size) * 100.0;
+}
+
+OrderSide ExecutionPlan::get_side() const
+{
+    return m_side;
+}
+
+Volume ExecutionPlan::get_original_order_size() const
+{
+    return m_original_order_size;
+}
+
+void ExecutionPlan::set_optimality(bool proven_optimal, Price optimality_gap, Volume volume_gap)
+{
+    m_optimizer_used = true;
+    m_proven_optimal = proven_optimal;
+    m_optimality_gap = optimality_gap;
+    m_optimality_volume_gap = volume_gap;
+}
+
+bool ExecutionPlan::is_optimizer_used() const
+{
+    return m_optimizer_used;
+}
+
+bool ExecutionPlan::is_proven_optimal() const
+{
+    return m_proven_optimal;
+}
+
+Price ExecutionPlan::get_optimality_gap() const
+{
+    return m_optimality_gap;
+}
+
+Volume ExecutionPlan::get_optimality_volume_gap() const
+{
+    return m_optimality_volume_gap;
+}
+
+void ExecutionPlan::set_coarsening_error_bound(Price bound)
+{
+    m_coarsening_error_bound = bound;
+}
+
+Price ExecutionPlan::get_coarsening_error_bound() const
+{
+    return m_coarsening_error_bound;
+}
+
+void ExecutionPlan::set_depth_limited_volume(Volume volume)
+{
+    m_depth_limited_volume = volume;
+}
+
+Volume ExecutionPlan::get_depth_limited_volume() const
+{
+    return m_depth_limited_volume;
 }
 
 void ExecutionPlan::print() const 
@@ -82,18 +148,13 @@ void ExecutionPlan::print() const
     std::cout << "Execution Plan:" << std::endl;
     for (const auto& record : m_plan) 
     {
-        const ExchangeName& exchange_name = record.exchange_name;
-        Price price = record.price;
-        Volume quantity = record.volume;
-        double fee_rate = m_order_books->at(exchange_name)->get_taker_fee();
-        Price fee_amount = quantity * price * fee_rate; // Actual fee amount
-        Price effective_price = (m_side == OrderSide::BUY) ? price * (1 + fee_rate) : price * (1 - fee_rate);
+        Price fee_amount = record.volume * record.price * record.fee_rate; // Actual fee amount
 
-        std::cout << "Exchange: " << exchange_name
-                  << ", Price: " << std::fixed << std::setprecision(2) << price
-                  << ", Quantity: " << std::fixed << std::setprecision(5) << quantity
+        std::cout << "Exchange: " << record.exchange_name
+                  << ", Price: " << std::fixed << std::setprecision(2) << record.price
+                  << ", Quantity: " << std::fixed << std::setprecision(5) << record.volume
                   << ", Fee Amount: " << std::fixed << std::setprecision(2) << fee_amount
-                  << ", Effective Price: " << effective_price << std::endl;
+                  << ", Effective Price: " << record.effective_price << std::endl;
     }
 
     std::cout << "\nMetrics:" << std::endl;
@@ -108,4 +169,122 @@ void ExecutionPlan::print() const
     }
     std::cout << "Average Effective Price: " << get_average_effective_price() << std::endl;
     std::cout << "Fulfillment Percentage: " << get_fulfillment_percentage() << "%" << std::endl;
-}
\ No newline at end of file
+    if (m_optimizer_used)
+    {
+        std::cout << "Optimizer: " << (m_proven_optimal ? "proven optimal" : "budget expired")
+                  << ", Optimality Gap: " << m_optimality_gap << ", Volume Gap: " << m_optimality_volume_gap << std::endl;
+    }
+    if (m_coarsening_error_bound > 0.0)
+    {
+        std::cout << "Coarsening Error Bound: " << m_coarsening_error_bound << std::endl;
+    }
+    if (m_depth_limited_volume > 0.0)
+    {
+        std::cout << "Held Back by Depth Limits: " << m_depth_limited_volume << std::endl;
+    }
+}
+
+void ExecutionPlan::encode(std::string& out) const
+{
+    put<uint8_t>(out, static_cast<uint8_t>(m_side));
+    put<uint8_t>(out, static_cast<uint8_t>((m_optimizer_used ? 1 : 0) | (m_proven_optimal ? 2 : 0)));
+    put<double>(out, m_original_order_size);
+    put<double>(out, m_filled_volume);
+    put<double>(out, m_total);
+    put<double>(out, m_total_fees);
+    put<double>(out, m_optimality_gap);
+    put<double>(out, m_optimality_volume_gap);
+    put<double>(out, m_coarsening_error_bound);
+    put<double>(out, m_depth_limited_volume);
+    put<uint32_t>(out, static_cast<uint32_t>(m_plan.size()));
+    for (const FillOrder& fill : m_plan) 
+    {
+        size_t length = std::min<size_t>(fill.exchange_name.size(), UINT8_MAX);
+        put<uint8_t>(out, static_cast<uint8_t>(length));
+        out.append(fill.exchange_name.data(), length);
+        put<double>(out, fill.price);
+        put<double>(out, fill.volume);
+        put<double>(out, fill.fee_rate);
+        put<double>(out, fill.effective_price);
+    }
+}
+
+bool ExecutionPlan::decode(const char* data, size_t size, ExecutionPlan& plan, size_t& consumed)
+{
+    size_t offset = 0;
+    uint8_t side, flags;
+    uint32_t fill_count;
+    ExecutionPlan decoded(OrderSide::BUY, 0.0);
+    if (!get(data, size, offset, side) || !get(data, size, offset, flags) ||
+        !get(data, size, offset, decoded.m_original_order_size) || !get(data, size, offset, decoded.m_filled_volume) ||
+        !get(data, size, offset, decoded.m_total) || !get(data, size, offset, decoded.m_total_fees) ||
+        !get(data, size, offset, decoded.m_optimality_gap) || !get(data, size, offset, decoded.m_optimality_volume_gap) ||
+        !get(data, size, offset, decoded.m_coarsening_error_bound) ||
+        !get(data, size, offset, decoded.m_depth_limited_volume) || !get(data, size, offset, fill_count)) 
+    {
+        return false;
+    }
+    if (side > static_cast<uint8_t>(OrderSide::SELL) || flags > 3) return false;
+    decoded.m_side = static_cast<OrderSide>(side);
+    decoded.m_optimizer_used = (flags & 1) != 0;
+    decoded.m_proven_optimal = (flags & 2) != 0;
+
+    // Every fill takes at least 33 bytes, which bounds the reservation for corrupt counts
+    decoded.m_plan.reserve(std::min<size_t>(fill_count, (size - offset) / 33));
+    for (uint32_t i = 0; i < fill_count; ++i) 
+    {
+        FillOrder fill;
+        uint8_t length;
+        if (!get(data, size, offset, length) || size - offset < length) return false;
+        fill.exchange_name.assign(data + offset, length);
+        offset += length;
+        if (!get(data, size, offset, fill.price) || !get(data, size, offset, fill.volume) ||
+            !get(data, size, offset, fill.fee_rate) || !get(data, size, offset, fill.effective_price)) 
+        {
+            return false;
+        }
+        decoded.m_plan.push_back(std::move(fill));
+    }
+    plan = std::move(decoded);
+    consumed = offset;
+    return true;
+}
+
+std::string ExecutionPlan::to_json() const
+{
+    std::string out;
+    out.reserve(256 + 128 * m_plan.size());
+    append_json(out);
+    return out;
+}
+
+void ExecutionPlan::append_json(std::string& out) const
+{
+    append_format(out, "{\"side\":\"%s\",\"requested\":%.8f,\"filled\":%.8f", m_side == OrderSide::BUY ? "BUY" : "SELL",
+                  m_original_order_size, m_filled_volume);
+    append_format(out, ",\"total\":%.8f,\"fees\":%.8f,\"avg_price\":%.8f,\"fulfillment\":%.4f",
+                  m_total, m_total_fees, get_average_effective_price(), get_fulfillment_percentage());
+    if (m_optimizer_used) 
+    {
+        append_format(out, ",\"proven_optimal\":%s,\"optimality_gap\":%.8f,\"volume_gap\":%.8f", m_proven_optimal ? "true" : "false",
+                      m_optimality_gap, m_optimality_volume_gap);
+    }
+    if (m_coarsening_error_bound > 0.0) 
+    {
+        append_format(out, ",\"coarsening_error_bound\":%.8f", m_coarsening_error_bound);
+    }
+    if (m_depth_limited_volume > 0.0) 
+    {
+        append_format(out, ",\"depth_limited\":%.8f", m_depth_limited_volume);
+    }
+    out += ",\"fills\":[";
+    for (size_t i = 0; i < m_plan.size(); ++i) 
+    {
+        const FillOrder& fill = m_plan[i];
+        out += (i == 0) ? "{\"exchange\":" : ",{\"exchange\":";
+        append_json_string(out, fill.exchange_name);
+        append_format(out, ",\"price\":%.8f,\"volume\":%.8f,\"fee_rate\":%.8f,\"effective_price\":%.8f}",
+                      fill.price, fill.volume, fill.fee_rate, fill.effective_price);
+    }
+    out += "]}";
+}
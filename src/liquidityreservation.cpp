@@ -0,0 +1,88 @@
+#include "liquidityreservation.h"
+#include <algorithm>
+
+LiquidityReservation::LiquidityReservation(ExecutionPlan plan, std::vector<LiquidityClaim> claims)
+    : m_plan(std::move(plan)), m_claims(std::move(claims)), m_active(true) {}
+
+LiquidityReservation::~LiquidityReservation()
+{
+    release();
+}
+
+LiquidityReservation::LiquidityReservation(LiquidityReservation&& other) noexcept
+    : m_plan(std::move(other.m_plan)), m_claims(std::move(other.m_claims)), m_active(other.m_active)
+{
+    other.m_active = false;
+}
+
+LiquidityReservation& LiquidityReservation::operator=(LiquidityReservation&& other) noexcept
+{
+    if (this != &other) 
+    {
+        release();
+        m_plan = std::move(other.m_plan);
+        m_claims = std::move(other.m_claims);
+        m_active = other.m_active;
+        other.m_active = false;
+    }
+    return *this;
+}
+
+const ExecutionPlan& LiquidityReservation::get_plan() const
+{
+    return m_plan;
+}
+
+const std::vector<LiquidityClaim>& LiquidityReservation::get_claims() const
+{
+    return m_claims;
+}
+
+bool LiquidityReservation::is_active() const
+{
+    return m_active;
+}
+
+ExecutionPlan LiquidityReservation::commit()
+{
+    if (m_active) 
+    {
+        m_active = false;
+        std::vector<OrderBook*> books;
+        for (const LiquidityClaim& claim : m_claims) 
+        {
+            claim.book->commit_claim(claim);
+            if (std::find(books.begin(), books.end(), claim.book) == books.end()) 
+            {
+                books.push_back(claim.book);
+            }
+        }
+        for (OrderBook* book : books) 
+        {
+            book->purge_depleted_levels();
+        }
+    }
+    return m_plan;
+}
+
+void LiquidityReservation::release()
+{
+    if (m_active) 
+    {
+        m_active = false;
+        std::vector<OrderBook*> books;
+        for (const LiquidityClaim& claim : m_claims) 
+        {
+            claim.book->release_claim(claim);
+            if (std::find(books.begin(), books.end(), claim.book) == books.end()) 
+            {
+                books.push_back(claim.book);
+            }
+        }
+        // Levels zeroed or demotions deferred while the claims were out are settled now
+        for (OrderBook* book : books) 
+        {
+            book->purge_depleted_levels();
+        }
+    }
+}
@@ -1,37 +1,230 @@
+#include "batchrunner.h"
 #include "orderbook.h"
+#include "planjournal.h"
+#include "routingserver.h"
+#include "snapshotloader.h"
 #include "smartorderrouter.h"
-#include "utils.h"
+#include "symbolregistry.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <memory>
 #include <filesystem>
 #include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 namespace fs = std::filesystem;
 
-int main() 
+static RoutingServer* g_server = nullptr;
+
+static void stop_server(int)
 {
-    auto binance = std::make_shared<OrderBook>("Binance", 0.001, 0.1);  // 0.1% fee, 0.1 min order size
-    auto kucoin = std::make_shared<OrderBook>("KuCoin", 0.0005, 0.15);  // 0.05% fee, 0.15 min order size
-    auto okx = std::make_shared<OrderBook>("OKX", 0.0002, 0.2);         // 0.02% fee, 0.2 min order size
+    if (g_server) g_server->stop();
+}
 
-    // Get the current executable's directory
-    fs::path data_dir = fs::path(__FILE__).parent_path().parent_path() / "data/";
-    
-    // Load order books using relative paths
-    read_csv((data_dir / "binance_order_book.csv").string(), *binance);
-    read_csv((data_dir / "kucoin_order_book.csv").string(), *kucoin);
-    read_csv((data_dir / "okx_order_book.csv").string(), *okx);
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--batch [orders_file]] [--format csv|jsonl] [--net N] [--serve unix:PATH|tcp:PORT]"
+              << " [--journal PATH [--journal-mb SIZE]] [--log-level LEVEL] [--manifest PATH [--symbol NAME]]\n";
+}
+
+// Parses a whole decimal count in [1, max]; strtoull alone accepts garbage as 0 and wraps negative input
+static bool parse_count(const char* text, size_t max, size_t& value)
+{
+    if (!std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed == 0 || parsed > max) return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
 
-    std::unordered_map<std::string, std::shared_ptr<OrderBook>> order_books = 
+int main(int argc, char* argv[]) 
+{
+    // Batch mode: smartorderrouter --batch [orders_file] [--format csv|jsonl] [--net N]
+    //             (--net nets every N consecutive orders and routes only the residual)
+    // Server mode: smartorderrouter --serve unix:PATH|tcp:PORT
+    // Any mode: --journal PATH [--journal-mb SIZE] records every routed plan,
+    //           --log-level trace|debug|info|warning|error|off sets the event log threshold,
+    //           --manifest PATH [--symbol NAME] loads the venue books listed in a manifest (data/manifest.csv by default)
+    bool batch_mode = false;
+    bool format_given = false;
+    std::string serve_address;
+    std::string journal_path;
+    std::string manifest_path = (fs::path(__FILE__).parent_path().parent_path() / "data/manifest.csv").string();
+    std::string symbol;
+    size_t journal_mb = 256;
+    size_t netting_window = 0;
+    std::string batch_file;
+    BatchFormat batch_format = BatchFormat::CSV;
+    for (int i = 1; i < argc; ++i) 
     {
-        {"Binance", binance},
-        {"KuCoin", kucoin},
-        {"OKX", okx}
-    };
-    
-    SmartOrderRouter router(std::move(order_books));
+        if (std::strcmp(argv[i], "--batch") == 0) 
+        {
+            batch_mode = true;
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) batch_file = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) 
+        {
+            serve_address = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--journal") == 0 && i + 1 < argc) 
+        {
+            journal_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) 
+        {
+            manifest_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--symbol") == 0 && i + 1 < argc) 
+        {
+            symbol = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--net") == 0 && i + 1 < argc) 
+        {
+            if (!parse_count(argv[++i], SIZE_MAX, netting_window)) 
+            {
+                std::cerr << "Invalid --net: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--journal-mb") == 0 && i + 1 < argc) 
+        {
+            // The capacity is journal_mb << 20 bytes, which has to fit in size_t
+            if (!parse_count(argv[++i], SIZE_MAX >> 20, journal_mb)) 
+            {
+                std::cerr << "Invalid --journal-mb: " << argv[i] << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) 
+        {
+            try 
+            {
+                EventLog::set_level(EventLog::parse_level(argv[++i]));
+            } 
+            catch (const std::invalid_argument& e) 
+            {
+                std::cerr << e.what() << " (expected trace, debug, info, warning, error or off)\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) 
+        {
+            std::string format = argv[++i];
+            format_given = true;
+            if (format == "csv") batch_format = BatchFormat::CSV;
+            else if (format == "jsonl") batch_format = BatchFormat::JSON_LINES;
+            else 
+            {
+                std::cerr << "Unknown format: " << format << " (expected csv or jsonl)\n";
+                return 1;
+            }
+        }
+        else 
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (batch_mode && !serve_address.empty()) 
+    {
+        std::cerr << "--batch and --serve are separate modes; pass only one of them\n";
+        return 1;
+    }
+    if ((format_given || netting_window > 0) && !batch_mode) 
+    {
+        std::cerr << "--format and --net apply to --batch only\n";
+        return 1;
+    }
+
+    // Venue books are parsed concurrently; the router is built once all of them are loaded
+    SymbolRegistry registry;
+    SymbolId symbol_id = 0;
+    try 
+    {
+        std::vector<ManifestEntry> manifest = read_manifest(manifest_path);
+        LoadReport report = load_snapshots(registry, manifest);
+        print_load_report(report, std::cerr);
+        if (report.failed != 0) return 1;
+        if (registry.size() == 0) throw std::runtime_error("Manifest " + manifest_path + " lists no venues");
+        symbol_id = symbol.empty() ? 0 : registry.get_symbol_id(symbol);
+    } 
+    catch (const std::exception& e) 
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    SmartOrderRouter& router = registry.get_router(symbol_id);
+
+    std::unique_ptr<PlanJournal> journal;
+    if (!journal_path.empty()) 
+    {
+        try 
+        {
+            journal = std::make_unique<PlanJournal>(journal_path, journal_mb << 20);
+        } 
+        catch (const std::exception& e) 
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (!serve_address.empty()) 
+    {
+        try 
+        {
+            RoutingServer server(router);
+            server.set_journal(journal.get());
+            if (serve_address.rfind("unix:", 0) == 0) server.listen_unix(serve_address.substr(5));
+            else if (serve_address.rfind("tcp:", 0) == 0) server.listen_tcp(static_cast<uint16_t>(std::stoi(serve_address.substr(4))));
+            else throw std::runtime_error("Expected unix:PATH or tcp:PORT, got " + serve_address);
+
+            g_server = &server;
+            std::signal(SIGINT, stop_server);
+            std::signal(SIGTERM, stop_server);
+            if (server.get_port() != 0) std::cerr << "Serving on tcp:" << server.get_port() << "\n";
+            else std::cerr << "Serving on " << serve_address << "\n";
+            server.run();
+            g_server = nullptr;
+            std::cerr << "Requests served: " << server.get_requests_served() << "\n";
+        } 
+        catch (const std::exception& e) 
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (batch_mode) 
+    {
+        std::ios::sync_with_stdio(false);
+        std::ifstream file;
+        if (!batch_file.empty() && batch_file != "-") 
+        {
+            file.open(batch_file);
+            if (!file.is_open()) 
+            {
+                std::cerr << "Could not open file: " << batch_file << "\n";
+                return 1;
+            }
+        }
+        std::istream& orders = file.is_open() ? static_cast<std::istream&>(file) : std::cin;
+        BatchSummary summary = run_batch(router, orders, std::cout, batch_format, journal.get(), netting_window);
+        print_batch_summary(summary, std::cerr);
+        return 0;
+    }
 
     while (true) 
     {
@@ -57,17 +250,18 @@ int main()
             char algorithm_choice;
             do 
             {
-                std::cout << "Choose algorithm - [G]reedy or [H]ybrid (G/H): ";
+                std::cout << "Choose algorithm - [G]reedy, [H]ybrid or [A]daptive (G/H/A): ";
                 std::cin >> algorithm_choice;
                 algorithm_choice = static_cast<char>(toupper(algorithm_choice));
-            } while (algorithm_choice != 'G' && algorithm_choice != 'H');
+            } while (algorithm_choice != 'G' && algorithm_choice != 'H' && algorithm_choice != 'A');
 
             RoutingAlgorithm algorithm = (algorithm_choice == 'G') 
                 ? RoutingAlgorithm::PURE_GREEDY 
-                : RoutingAlgorithm::HYBRID;
+                : (algorithm_choice == 'A') ? RoutingAlgorithm::ADAPTIVE : RoutingAlgorithm::HYBRID;
    
             OrderSide side = (order_size > 0) ? OrderSide::BUY : OrderSide::SELL;
             ExecutionPlan execution_plan = router.distribute_order(std::abs(order_size), side, algorithm);
+            if (journal) journal->record(execution_plan);
             execution_plan.print();
         } catch (...) {
             std::cerr << "Invalid input. Please enter a number or command.\n";
@@ -0,0 +1,99 @@
+#include "netting.h"
+#include <algorithm>
+
+const ExchangeName INTERNAL_VENUE = "INTERNAL";
+
+namespace
+{
+constexpr Volume NETTING_EPSILON = 1e-9;
+
+// Mid of the best bid and best ask over every venue, 0 when either side is empty everywhere
+Price get_reference_mid(const SmartOrderRouter& router)
+{
+    Price best_bid = 0.0;
+    Price best_ask = 0.0;
+    for (const LiquiditySnapshot& snapshot : router.get_liquidity_snapshots())
+    {
+        if (snapshot.bids.best_price > 0.0) best_bid = std::max(best_bid, snapshot.bids.best_price);
+        if (snapshot.asks.best_price > 0.0 && (best_ask == 0.0 || snapshot.asks.best_price < best_ask))
+        {
+            best_ask = snapshot.asks.best_price;
+        }
+    }
+    return (best_bid > 0.0 && best_ask > 0.0) ? (best_bid + best_ask) / 2 : 0.0;
+}
+}
+
+NettingResult net_and_route(SmartOrderRouter& router, const std::vector<ParentOrder>& parents)
+{
+    NettingResult result;
+    Volume buy_total = 0.0;
+    Volume sell_total = 0.0;
+    for (const ParentOrder& parent : parents)
+    {
+        (parent.side == OrderSide::BUY ? buy_total : sell_total) += parent.size;
+    }
+
+    Volume crossed = std::min(buy_total, sell_total);
+    Price mid = (crossed > NETTING_EPSILON) ? get_reference_mid(router) : 0.0;
+    result.plans.reserve(parents.size());
+    if (mid <= 0.0)
+    {
+        for (const ParentOrder& parent : parents)
+        {
+            result.plans.push_back(router.distribute_order(parent.size, parent.side, parent.algorithm));
+            ++result.routing_calls;
+        }
+        result.residual_volume = buy_total + sell_total;
+        return result;
+    }
+    result.reference_mid = mid;
+    result.crossed_volume = crossed;
+
+    // Each side crosses pro rata, so the side with less volume is matched in full
+    OrderSide net_side = (buy_total >= sell_total) ? OrderSide::BUY : OrderSide::SELL;
+    Volume net_total = std::max(buy_total, sell_total);
+    std::vector<Volume> residuals(parents.size(), 0.0);
+    RoutingAlgorithm residual_algorithm = RoutingAlgorithm::PURE_GREEDY;
+    for (size_t i = 0; i < parents.size(); ++i)
+    {
+        const ParentOrder& parent = parents[i];
+        ExecutionPlan plan(parent.side, parent.size);
+        Volume internal = parent.size;
+        if (parent.side == net_side)
+        {
+            internal = parent.size * crossed / net_total;
+            residuals[i] = parent.size - internal;
+            // The residual gets the most thorough algorithm any of its parents asked for
+            if (parent.algorithm == RoutingAlgorithm::HYBRID) residual_algorithm = RoutingAlgorithm::HYBRID;
+            if (parent.algorithm == RoutingAlgorithm::ADAPTIVE && residual_algorithm == RoutingAlgorithm::PURE_GREEDY) 
+            {
+                residual_algorithm = RoutingAlgorithm::ADAPTIVE;
+            }
+        }
+        // Crossed internally, so no venue fee applies
+        if (internal > NETTING_EPSILON) plan.add_fill(FillOrder(INTERNAL_VENUE, mid, internal, 0.0));
+        result.plans.push_back(std::move(plan));
+    }
+
+    result.residual_volume = net_total - crossed;
+    if (result.residual_volume <= NETTING_EPSILON) return result;
+
+    ExecutionPlan residual = router.distribute_order(result.residual_volume, net_side, residual_algorithm);
+    ++result.routing_calls;
+    for (size_t i = 0; i < parents.size(); ++i)
+    {
+        if (residuals[i] <= NETTING_EPSILON) continue;
+        double share = residuals[i] / result.residual_volume;
+        for (const FillOrder& fill : residual.get_plan())
+        {
+            result.plans[i].add_fill(FillOrder(fill.exchange_name, fill.price, fill.volume * share, fill.fee_rate));
+        }
+        if (residual.is_optimizer_used())
+        {
+            result.plans[i].set_optimality(residual.is_proven_optimal(), residual.get_optimality_gap() * share,
+                                           residual.get_optimality_volume_gap() * share);
+        }
+    }
+    return result;
+}
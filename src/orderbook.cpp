@@ -1,25 +1,211 @@
 #include "orderbook.h"
+#include <algorithm>
 #include <limits>
+#include <mutex>
+
+bool PriceLevel::compare_exchange(Volume& expected, Volume desired) const
+{
+    return m_volume.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+Volume PriceLevel::add(Volume volume) const
+{
+    Volume current = load();
+    while (!compare_exchange(current, current + volume)) {}
+    return current;
+}
+
+PriceLevel& PriceLevel::operator=(const PriceLevel& other)
+{
+    m_volume.store(other.load(), std::memory_order_release);
+    return *this;
+}
+
+PriceLevel& PriceLevel::operator+=(Volume volume)
+{
+    add(volume);
+    return *this;
+}
 
 // Constructor
 OrderBook::OrderBook(const std::string& exchange_name, double taker_fee, double min_order_size)
     : m_exchange_name(exchange_name), m_taker_fee(taker_fee), min_order_size(min_order_size) {}
 
+bool OrderBook::can_erase() const
+{
+    return m_pending_claims.load(std::memory_order_acquire) == 0;
+}
+
+void OrderBook::drop_level(PriceLevels& levels, PriceLevels::iterator level)
+{
+    if (can_erase()) levels.erase(level);
+    else level->second = PriceLevel(0.0);   // A claim may still point here; purge_depleted_levels erases it
+}
+
+OrderBook::RunningTotals& OrderBook::get_totals(OrderSide side)
+{
+    return (side == OrderSide::BUY) ? m_ask_totals : m_bid_totals;
+}
+
+void OrderBook::account(RunningTotals& totals, Price price, Volume before, Volume after)
+{
+    Volume delta = after - before;
+    Volume volume = totals.volume.load(std::memory_order_relaxed);
+    while (!totals.volume.compare_exchange_weak(volume, volume + delta, std::memory_order_relaxed)) {}
+    Price notional = totals.notional.load(std::memory_order_relaxed);
+    while (!totals.notional.compare_exchange_weak(notional, notional + price * delta, std::memory_order_relaxed)) {}
+    int64_t levels = static_cast<int64_t>(after > 0.0) - static_cast<int64_t>(before > 0.0);
+    if (levels != 0) totals.levels.fetch_add(levels, std::memory_order_relaxed);
+    totals.changes.fetch_add(1, std::memory_order_release);
+}
+
+bool OrderBook::is_cold(const ColdStore& cold, bool bids, Price price)
+{
+    if (cold.levels.empty()) return false;
+    return bids ? price <= cold.levels.rbegin()->first : price >= cold.levels.begin()->first;
+}
+
+void OrderBook::set_cold(ColdStore& cold, Price price, Volume volume)
+{
+    auto it = cold.levels.find(price);
+    if (it != cold.levels.end()) 
+    {
+        cold.volume -= it->second;
+        cold.levels.erase(it);
+    }
+    if (volume > 0) 
+    {
+        cold.levels.emplace(price, volume);
+        cold.volume += volume;
+    }
+    if (cold.levels.empty()) cold.volume = 0.0;
+}
+
+bool OrderBook::rebalance(bool bids)
+{
+    PriceLevels& hot = bids ? m_bids : m_asks;
+    ColdStore& cold = bids ? m_cold_bids : m_cold_asks;
+    RunningTotals& totals = bids ? m_bid_totals : m_ask_totals;
+    if (m_depth_limits.max_depth == 0 && m_depth_limits.price_band_bps <= 0.0 && cold.levels.empty()) return false;
+
+    bool moved = false;
+    double band = m_depth_limits.price_band_bps / 10000.0;
+    auto in_window = [&](Price best, Price price, size_t depth) 
+    {
+        if (m_depth_limits.max_depth != 0 && depth > m_depth_limits.max_depth) return false;
+        if (band <= 0.0) return true;
+        return bids ? price >= best * (1.0 - band) : price <= best * (1.0 + band);
+    };
+
+    // Demote from the worst end of the hot side
+    while (!hot.empty()) 
+    {
+        Price best = bids ? hot.rbegin()->first : hot.begin()->first;
+        auto worst = bids ? hot.begin() : std::prev(hot.end());
+        if (in_window(best, worst->first, hot.size())) break;
+        if (!can_erase()) break;    // Deferred until the claims settle, see purge_depleted_levels
+        Volume volume = worst->second.load();
+        account(totals, worst->first, volume, 0.0);
+        set_cold(cold, worst->first, volume);
+        hot.erase(worst);
+        moved = true;
+    }
+
+    // Promote the best cold levels while they fit
+    while (!cold.levels.empty()) 
+    {
+        auto candidate = bids ? std::prev(cold.levels.end()) : cold.levels.begin();
+        Price best = hot.empty() ? candidate->first : (bids ? hot.rbegin()->first : hot.begin()->first);
+        if (!in_window(best, candidate->first, hot.size() + 1)) break;
+        hot.emplace(candidate->first, PriceLevel(candidate->second));
+        account(totals, candidate->first, 0.0, candidate->second);
+        set_cold(cold, candidate->first, 0.0);
+        moved = true;
+    }
+    return moved;
+}
+
 void OrderBook::add_bid(Price price, Volume volume) 
 {
-    m_bids[price] += volume; // Aggregate volumes at the same price
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto cold = m_cold_bids.levels.find(price);
+    if (cold != m_cold_bids.levels.end() || is_cold(m_cold_bids, true, price)) 
+    {
+        set_cold(m_cold_bids, price, volume + ((cold != m_cold_bids.levels.end()) ? cold->second : 0.0));
+    } 
+    else 
+    {
+        Volume before = m_bids[price].add(volume); // Aggregate volumes at the same price
+        account(m_bid_totals, price, before, before + volume);
+        rebalance(true);
+    }
+    ++m_version;
 }
 
 void OrderBook::add_ask(Price price, Volume volume) 
 {
-    m_asks[price] += volume; // Aggregate volumes at the same price
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto cold = m_cold_asks.levels.find(price);
+    if (cold != m_cold_asks.levels.end() || is_cold(m_cold_asks, false, price)) 
+    {
+        set_cold(m_cold_asks, price, volume + ((cold != m_cold_asks.levels.end()) ? cold->second : 0.0));
+    } 
+    else 
+    {
+        Volume before = m_asks[price].add(volume); // Aggregate volumes at the same price
+        account(m_ask_totals, price, before, before + volume);
+        rebalance(false);
+    }
+    ++m_version;
+}
+
+void OrderBook::set_bid_volume(Price price, Volume volume) 
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (is_cold(m_cold_bids, true, price)) 
+    {
+        set_cold(m_cold_bids, price, volume);
+    } 
+    else 
+    {
+        auto it = m_bids.find(price);
+        account(m_bid_totals, price, (it != m_bids.end()) ? it->second.load() : 0.0, std::max(volume, 0.0));
+        if (volume > 0) m_bids[price] = PriceLevel(volume);
+        else if (it != m_bids.end()) drop_level(m_bids, it);
+    }
+    rebalance(true);
+    ++m_version;
+}
+
+void OrderBook::set_ask_volume(Price price, Volume volume) 
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (is_cold(m_cold_asks, false, price)) 
+    {
+        set_cold(m_cold_asks, price, volume);
+    } 
+    else 
+    {
+        auto it = m_asks.find(price);
+        account(m_ask_totals, price, (it != m_asks.end()) ? it->second.load() : 0.0, std::max(volume, 0.0));
+        if (volume > 0) m_asks[price] = PriceLevel(volume);
+        else if (it != m_asks.end()) drop_level(m_asks, it);
+    }
+    rebalance(false);
+    ++m_version;
 }
 
 void OrderBook::remove_top_bid() 
 {
-    if (!m_bids.empty()) 
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto top = m_bids.rbegin();
+    while (top != m_bids.rend() && top->second.load() <= 0.0) ++top;   // Skip levels left for the purge
+    if (top != m_bids.rend()) 
     {
-        m_bids.erase(--m_bids.end());
+        account(m_bid_totals, top->first, top->second.load(), 0.0);
+        drop_level(m_bids, std::prev(top.base()));
+        rebalance(true);
+        ++m_version;
     } else 
     {
         throw std::runtime_error("No bids available to remove.");
@@ -28,9 +214,15 @@ void OrderBook::remove_top_bid()
 
 void OrderBook::remove_top_ask() 
 {
-    if (!m_asks.empty()) 
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto top = m_asks.begin();
+    while (top != m_asks.end() && top->second.load() <= 0.0) ++top;
+    if (top != m_asks.end()) 
     {
-        m_asks.erase(m_asks.begin());
+        account(m_ask_totals, top->first, top->second.load(), 0.0);
+        drop_level(m_asks, top);
+        rebalance(false);
+        ++m_version;
     }
     else 
     {
@@ -40,20 +232,22 @@ void OrderBook::remove_top_ask()
 
 std::pair<Price, Volume> OrderBook::get_best_bid() const 
 {
-    if (m_bids.empty()) 
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    for (auto it = m_bids.rbegin(); it != m_bids.rend(); ++it) 
     {
-        return {0.0, 0.0}; // No bids available
+        if (it->second.load() > 0.0) return *it;    // Skip levels fully claimed by in-flight plans
     }
-    return *m_bids.rbegin();
+    return {0.0, 0.0}; // No bids available
 }
 
 std::pair<Price, Volume> OrderBook::get_best_ask() const 
 {
-    if (m_asks.empty()) 
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    for (const auto& level : m_asks) 
     {
-        return {0.0, 0.0}; // No asks available
+        if (level.second.load() > 0.0) return level;    // First non-empty element in the map
     }
-    return *m_asks.begin(); // First element in the map
+    return {0.0, 0.0}; // No asks available
 }
 
 double OrderBook::get_taker_fee() const 
@@ -66,12 +260,22 @@ double OrderBook::get_min_order_size() const
     return min_order_size;
 }
 
-const std::map<Price, Volume>& OrderBook::get_bids() const 
+uint64_t OrderBook::get_version() const 
+{
+    return m_version.load(std::memory_order_acquire);
+}
+
+uint64_t OrderBook::get_side_version(OrderSide side) const 
+{
+    return ((side == OrderSide::BUY) ? m_ask_totals : m_bid_totals).changes.load(std::memory_order_acquire);
+}
+
+const PriceLevels& OrderBook::get_bids() const 
 {
     return m_bids;
 }
 
-const std::map<Price, Volume>& OrderBook::get_asks() const 
+const PriceLevels& OrderBook::get_asks() const 
 {
     return m_asks;
 }
@@ -81,46 +285,205 @@ const ExchangeName OrderBook::get_exchange_name() const
     return m_exchange_name;
 }
 
+void OrderBook::set_depth_limits(const DepthLimits& limits)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_depth_limits = limits;
+    rebalance(true);
+    rebalance(false);
+    ++m_version;
+}
+
+DepthLimits OrderBook::get_depth_limits() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_depth_limits;
+}
+
+Volume OrderBook::get_cold_volume(OrderSide side) const
+{
+    return ((side == OrderSide::BUY) ? m_cold_asks : m_cold_bids).volume;
+}
+
 void OrderBook::reduce_bid_volume(Price price, Volume reduction) 
 {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
     auto it = m_bids.find(price);
     if (it != m_bids.end()) 
     {
-        it->second -= reduction;
-        if (it->second <= min_order_size) 
+        ++m_version;
+        Volume before = it->second.add(-reduction);
+        if (before - reduction <= min_order_size) 
+        {
+            account(m_bid_totals, price, before, 0.0);
+            drop_level(m_bids, it);  // Remove if volume depleted
+            rebalance(true);
+        }
+        else 
         {
-            m_bids.erase(it);  // Remove if volume depleted
+            account(m_bid_totals, price, before, before - reduction);
         }
     }
+    else if (m_cold_bids.levels.count(price) != 0) 
+    {
+        ++m_version;
+        Volume remaining = m_cold_bids.levels[price] - reduction;
+        set_cold(m_cold_bids, price, (remaining <= min_order_size) ? 0.0 : remaining);
+    }
 }
 
 void OrderBook::reduce_ask_volume(Price price, Volume reduction) 
 {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
     auto it = m_asks.find(price);
     if (it != m_asks.end()) 
     {
-        it->second -= reduction;
-        if (it->second <= min_order_size) 
+        ++m_version;
+        Volume before = it->second.add(-reduction);
+        if (before - reduction <= min_order_size) 
+        {
+            account(m_ask_totals, price, before, 0.0);
+            drop_level(m_asks, it);  // Remove if volume depleted
+            rebalance(false);
+        }
+        else 
         {
-            m_asks.erase(it);  // Remove if volume depleted
+            account(m_ask_totals, price, before, before - reduction);
         }
     }
+    else if (m_cold_asks.levels.count(price) != 0) 
+    {
+        ++m_version;
+        Volume remaining = m_cold_asks.levels[price] - reduction;
+        set_cold(m_cold_asks, price, (remaining <= min_order_size) ? 0.0 : remaining);
+    }
 }
 
 Volume OrderBook::get_bid_volume(Price price) const 
 {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
     auto it = m_bids.find(price);
-    return (it != m_bids.end()) ? it->second : 0.0;
+    if (it != m_bids.end()) return it->second.load();
+    auto cold = m_cold_bids.levels.find(price);
+    return (cold != m_cold_bids.levels.end()) ? cold->second : 0.0;
 }
 
 Volume OrderBook::get_ask_volume(Price price) const 
 {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
     auto it = m_asks.find(price);
-    return (it != m_asks.end()) ? it->second : 0.0;
+    if (it != m_asks.end()) return it->second.load();
+    auto cold = m_cold_asks.levels.find(price);
+    return (cold != m_cold_asks.levels.end()) ? cold->second : 0.0;
+}
+
+std::shared_lock<std::shared_mutex> OrderBook::read_lock() const
+{
+    return std::shared_lock<std::shared_mutex>(m_mutex);
+}
+
+bool OrderBook::try_claim(OrderSide side, PriceLevels::const_iterator level, Volume& observed, Volume volume)
+{
+    if (volume > observed || !level->second.compare_exchange(observed, observed - volume)) 
+    {
+        observed = level->second.load();
+        return false;
+    }
+    account(get_totals(side), level->first, observed, observed - volume);
+    m_pending_claims.fetch_add(1, std::memory_order_acq_rel);
+    ++m_version;
+    return true;
+}
+
+void OrderBook::commit_claim(const LiquidityClaim&)
+{
+    m_pending_claims.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void OrderBook::release_claim(const LiquidityClaim& claim)
+{
+    Volume before = claim.level->add(claim.volume);
+    account(get_totals(claim.side), claim.price, before, before + claim.volume);
+    ++m_version;
+    m_pending_claims.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void OrderBook::purge_depleted_levels()
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_pending_claims.load(std::memory_order_acquire) != 0) 
+    {
+        return;
+    }
+
+    bool erased = false;
+    for (PriceLevels* levels : {&m_bids, &m_asks}) 
+    {
+        for (auto it = levels->begin(); it != levels->end();) 
+        {
+            if (it->second.load() <= 0.0) 
+            {
+                it = levels->erase(it);
+                erased = true;
+            } 
+            else 
+            {
+                ++it;
+            }
+        }
+    }
+    // Consumed top levels make room for cold ones, and demotions deferred while claims were pending run now
+    bool moved = rebalance(true);
+    moved = rebalance(false) || moved;
+    if (erased || moved) ++m_version;
+}
+
+LiquiditySnapshot OrderBook::get_liquidity_snapshot() const
+{
+    LiquiditySnapshot snapshot;
+    snapshot.exchange_name = m_exchange_name;
+    auto read_totals = [](const RunningTotals& totals, SideLiquidity& side)
+    {
+        int64_t levels = totals.levels.load(std::memory_order_relaxed);
+        if (levels <= 0) return;    // Drop the rounding residue of a side that emptied
+        side.levels = static_cast<size_t>(levels);
+        side.volume = totals.volume.load(std::memory_order_relaxed);
+        side.notional = totals.notional.load(std::memory_order_relaxed);
+    };
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    snapshot.version = m_version.load(std::memory_order_acquire);
+    read_totals(m_bid_totals, snapshot.bids);
+    read_totals(m_ask_totals, snapshot.asks);
+    snapshot.bids.cold_volume = m_cold_bids.volume;
+    snapshot.bids.cold_levels = m_cold_bids.levels.size();
+    snapshot.asks.cold_volume = m_cold_asks.volume;
+    snapshot.asks.cold_levels = m_cold_asks.levels.size();
+    // Only levels fully claimed by in-flight plans are skipped, so these loops stop almost at once
+    for (auto it = m_bids.rbegin(); it != m_bids.rend() && snapshot.bids.levels > 0; ++it) 
+    {
+        if (it->second.load() > 0.0) 
+        {
+            snapshot.bids.best_price = it->first;
+            snapshot.bids.best_volume = it->second.load();
+            break;
+        }
+    }
+    for (auto it = m_asks.begin(); it != m_asks.end() && snapshot.asks.levels > 0; ++it) 
+    {
+        if (it->second.load() > 0.0) 
+        {
+            snapshot.asks.best_price = it->first;
+            snapshot.asks.best_volume = it->second.load();
+            break;
+        }
+    }
+    return snapshot;
 }
 
 void OrderBook::print_order_book() const 
 {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
     std::cout << "Order Book for " << m_exchange_name << ":" << std::endl;
     std::cout << "Taker Fee: " << m_taker_fee * 100 << "%" << std::endl;
     std::cout << "Minimum Order Size: " << min_order_size << std::endl;
@@ -128,14 +491,14 @@ void OrderBook::print_order_book() const
     std::cout << "Bids:" << std::endl;
     for (auto it = m_bids.rbegin(); it != m_bids.rend(); ++it) 
     {
-        std::cout << "Price: " << it->first << ", Volume: " << it->second << std::endl;
+        std::cout << "Price: " << it->first << ", Volume: " << it->second.load() << std::endl;
     }
 
     std::cout << "Asks:" << std::endl;
     for (const auto& entry : m_asks) 
     {
-        std::cout << "Price: " << entry.first << ", Volume: " << entry.second << std::endl;
+        std::cout << "Price: " << entry.first << ", Volume: " << entry.second.load() << std::endl;
     }
 
     std::cout << std::endl;
-}
\ No newline at end of file
+}
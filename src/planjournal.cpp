@@ -0,0 +1,352 @@
+#include "planjournal.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr uint32_t JOURNAL_VERSION = 1;
+constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+constexpr size_t PLAN_BODY_SIZE = 56;   // Fixed part of a PLAN record, see planjournal.h
+// Long enough that the writer rarely preempts routing, short enough that the ring never fills
+constexpr auto WRITER_IDLE_SLEEP = std::chrono::milliseconds(1);
+constexpr auto FLUSH_POLL = std::chrono::microseconds(50);
+
+size_t align8(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+template <typename T>
+char* put(char* out, const T& value)
+{
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+template <typename T>
+const char* get(const char* in, T& value)
+{
+    std::memcpy(&value, in, sizeof(T));
+    return in + sizeof(T);
+}
+}
+
+PlanJournal::PlanJournal(const std::string& path, size_t capacity_bytes, size_t ring_slots)
+{
+    if (capacity_bytes < sizeof(JournalFileHeader)) throw std::runtime_error("Journal capacity too small: " + path);
+
+    size_t slots = 2;
+    while (slots < ring_slots) slots <<= 1;
+    m_ring.resize(slots);
+    m_mask = slots - 1;
+
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) throw std::runtime_error("Could not open journal " + path + ": " + std::strerror(errno));
+    // Reserve the blocks up front so a full disk fails here instead of as SIGBUS on a mapped write
+    int error = posix_fallocate(m_fd, 0, static_cast<off_t>(capacity_bytes));
+    void* map = (error == 0) ? mmap(nullptr, capacity_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, 0)
+                             : MAP_FAILED;
+    if (map == MAP_FAILED) 
+    {
+        std::string reason = std::strerror(error != 0 ? error : errno);
+        close(m_fd);
+        throw std::runtime_error("Could not map journal " + path + ": " + reason);
+    }
+    m_map = static_cast<char*>(map);
+    m_capacity = capacity_bytes;
+
+    JournalFileHeader header{};
+    std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.header_size = sizeof(JournalFileHeader);
+    header.capacity = capacity_bytes;
+    header.write_offset = sizeof(JournalFileHeader);
+    std::memcpy(m_map, &header, sizeof(header));
+    m_write_offset = sizeof(JournalFileHeader);
+
+    m_writer = std::thread(&PlanJournal::writer_loop, this);
+}
+
+PlanJournal::~PlanJournal()
+{
+    m_running.store(false, std::memory_order_release);
+    m_writer.join();
+    publish_header();
+    msync(m_map, m_capacity, MS_SYNC);
+    munmap(m_map, m_capacity);
+    close(m_fd);
+}
+
+bool PlanJournal::record(const ExecutionPlan& plan)
+{
+    const std::vector<FillOrder>& fills = plan.get_plan();
+    uint64_t sequence = m_next_sequence++;
+
+    // Venues seen for the first time need a VENUE slot ahead of the plan
+    ExchangeName new_venues[FILLS_PER_SLOT];
+    size_t new_venue_count = 0;
+    std::vector<ExchangeName> overflow_venues;
+    for (const FillOrder& fill : fills) 
+    {
+        if (m_venue_ids.count(fill.exchange_name)) continue;
+        if (std::find(new_venues, new_venues + new_venue_count, fill.exchange_name) != new_venues + new_venue_count) continue;
+        if (std::find(overflow_venues.begin(), overflow_venues.end(), fill.exchange_name) != overflow_venues.end()) continue;
+        if (new_venue_count < FILLS_PER_SLOT) new_venues[new_venue_count++] = fill.exchange_name;
+        else overflow_venues.push_back(fill.exchange_name);
+    }
+
+    size_t fill_slots = fills.size() > FILLS_PER_SLOT ? (fills.size() - 1) / FILLS_PER_SLOT : 0;
+    size_t required = new_venue_count + overflow_venues.size() + 1 + fill_slots;
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t free_slots = m_ring.size() - (head - m_tail.load(std::memory_order_acquire));
+    if (required > free_slots) 
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto push_venue = [&](const ExchangeName& name) 
+    {
+        uint32_t venue_id = static_cast<uint32_t>(m_venue_ids.size());
+        m_venue_ids.emplace(name, venue_id);
+        Slot& slot = m_ring[head++ & m_mask];
+        slot.kind = Slot::Kind::VENUE;
+        slot.fills[0].venue_id = venue_id;
+        size_t length = std::min(name.size(), VENUE_NAME_SIZE - 1);
+        std::memcpy(slot.venue_name, name.data(), length);
+        slot.venue_name[length] = '\0';
+    };
+    for (size_t i = 0; i < new_venue_count; ++i) push_venue(new_venues[i]);
+    for (const ExchangeName& name : overflow_venues) push_venue(name);
+
+    Slot* slot = &m_ring[head++ & m_mask];
+    slot->kind = Slot::Kind::PLAN;
+    slot->side = static_cast<uint8_t>(plan.get_side());
+    slot->flags = (plan.is_optimizer_used() ? JOURNAL_OPTIMIZER_USED : 0) | (plan.is_proven_optimal() ? JOURNAL_PROVEN_OPTIMAL : 0);
+    slot->total_fills = static_cast<uint32_t>(fills.size());
+    slot->sequence = sequence;
+    slot->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->requested = plan.get_original_order_size();
+    slot->total = plan.get_total();
+    slot->fees = plan.get_total_fees();
+    slot->optimality_gap = plan.get_optimality_gap();
+    slot->fill_count = 0;
+    for (const FillOrder& fill : fills) 
+    {
+        if (slot->fill_count == FILLS_PER_SLOT) 
+        {
+            slot = &m_ring[head++ & m_mask];
+            slot->kind = Slot::Kind::FILLS;
+            slot->fill_count = 0;
+        }
+        slot->fills[slot->fill_count++] = {m_venue_ids.at(fill.exchange_name), 0, fill.price, fill.volume};
+    }
+
+    m_head.store(head, std::memory_order_release);
+    return true;
+}
+
+char* PlanJournal::reserve_record(JournalRecordType type, size_t body_size)
+{
+    size_t size = align8(RECORD_HEADER_SIZE + body_size);
+    if (m_capacity - m_write_offset < size) return nullptr;
+
+    char* record = m_map + m_write_offset;
+    put<uint32_t>(put<uint32_t>(record, static_cast<uint32_t>(type)), static_cast<uint32_t>(size));
+    m_write_offset += size;
+    return record + RECORD_HEADER_SIZE;
+}
+
+bool PlanJournal::drain()
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    if (tail == head) return false;
+
+    // New venues are written together with the first plan that uses them, or not at all
+    uint64_t venues_begin = tail;
+    size_t venue_bytes = 0;
+    while (tail != head) 
+    {
+        const Slot& slot = m_ring[tail++ & m_mask];
+        if (slot.kind == Slot::Kind::VENUE) 
+        {
+            venue_bytes += align8(RECORD_HEADER_SIZE + 2 * sizeof(uint32_t) + std::strlen(slot.venue_name));
+            continue;
+        }
+
+        // A PLAN slot is always followed by the FILLS slots of the same plan. Once a plan does not fit the
+        // journal stays full: the venues it would have introduced are already assigned ids, so a later,
+        // smaller plan could otherwise reference a venue that is missing from the file.
+        size_t plan_body_size = PLAN_BODY_SIZE + slot.total_fills * sizeof(JournalFill);
+        char* out = nullptr;
+        if (!m_full && m_capacity - m_write_offset >= venue_bytes + align8(RECORD_HEADER_SIZE + plan_body_size)) 
+        {
+            for (uint64_t v = venues_begin; v + 1 != tail; ++v) 
+            {
+                const Slot& venue = m_ring[v & m_mask];
+                uint32_t name_length = static_cast<uint32_t>(std::strlen(venue.venue_name));
+                char* body = reserve_record(JournalRecordType::VENUE, 2 * sizeof(uint32_t) + name_length);
+                std::memcpy(put(put(body, venue.fills[0].venue_id), name_length), venue.venue_name, name_length);
+            }
+            out = reserve_record(JournalRecordType::PLAN, plan_body_size);
+        }
+        else 
+        {
+            m_full = true;
+        }
+        if (out) 
+        {
+            out = put(out, slot.sequence);
+            out = put(out, slot.timestamp_ns);
+            out = put(out, slot.requested);
+            out = put(out, slot.total);
+            out = put(out, slot.fees);
+            out = put(out, slot.optimality_gap);
+            out = put(out, slot.side);
+            out = put(out, slot.flags);
+            out = put<uint16_t>(out, 0);
+            out = put(out, slot.total_fills);
+            m_written.fetch_add(1, std::memory_order_relaxed);
+        }
+        else 
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t remaining = slot.total_fills;
+        const Slot* chunk = &slot;
+        while (true) 
+        {
+            if (out) 
+            {
+                std::memcpy(out, chunk->fills, chunk->fill_count * sizeof(JournalFill));
+                out += chunk->fill_count * sizeof(JournalFill);
+            }
+            remaining -= chunk->fill_count;
+            if (remaining == 0) break;
+            chunk = &m_ring[tail++ & m_mask];
+        }
+        venues_begin = tail;
+        venue_bytes = 0;
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+    publish_header();
+    return true;
+}
+
+void PlanJournal::publish_header()
+{
+    // Records are complete before the offset that exposes them is written
+    JournalFileHeader* header = reinterpret_cast<JournalFileHeader*>(m_map);
+    header->plans = m_written.load(std::memory_order_relaxed);
+    header->dropped = m_dropped.load(std::memory_order_relaxed);
+    header->write_offset = m_write_offset;
+}
+
+void PlanJournal::writer_loop()
+{
+    while (m_running.load(std::memory_order_acquire)) 
+    {
+        if (!drain()) std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+    }
+    drain();
+}
+
+void PlanJournal::flush()
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    while (m_tail.load(std::memory_order_acquire) < head) 
+    {
+        std::this_thread::sleep_for(FLUSH_POLL);
+    }
+}
+
+uint64_t PlanJournal::get_written() const
+{
+    return m_written.load(std::memory_order_relaxed);
+}
+
+uint64_t PlanJournal::get_dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+JournalContents read_journal(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("Could not open journal: " + path);
+
+    JournalContents contents;
+    if (!file.read(reinterpret_cast<char*>(&contents.header), sizeof(JournalFileHeader)) ||
+        std::memcmp(contents.header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        contents.header.version != JOURNAL_VERSION || contents.header.write_offset < sizeof(JournalFileHeader)) 
+    {
+        throw std::runtime_error("Not a plan journal: " + path);
+    }
+
+    std::vector<char> data(contents.header.write_offset - sizeof(JournalFileHeader));
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) throw std::runtime_error("Truncated journal: " + path);
+
+    std::unordered_map<uint32_t, ExchangeName> venues;
+    size_t offset = 0;
+    while (offset < data.size()) 
+    {
+        uint32_t type, size;
+        if (data.size() - offset < RECORD_HEADER_SIZE) throw std::runtime_error("Truncated journal record: " + path);
+        get(get(data.data() + offset, type), size);
+        if (size < RECORD_HEADER_SIZE || size > data.size() - offset) throw std::runtime_error("Corrupt journal record: " + path);
+        const char* body = data.data() + offset + RECORD_HEADER_SIZE;
+        size_t body_size = size - RECORD_HEADER_SIZE;
+        offset += size;
+
+        if (type == static_cast<uint32_t>(JournalRecordType::VENUE) && body_size >= 2 * sizeof(uint32_t)) 
+        {
+            uint32_t venue_id, name_length;
+            const char* name = get(get(body, venue_id), name_length);
+            if (name_length > body_size - 2 * sizeof(uint32_t)) throw std::runtime_error("Corrupt venue record: " + path);
+            venues[venue_id] = ExchangeName(name, name_length);
+        }
+        else if (type == static_cast<uint32_t>(JournalRecordType::PLAN) && body_size >= PLAN_BODY_SIZE) 
+        {
+            JournalEntry entry;
+            uint8_t side;
+            uint16_t reserved;
+            uint32_t fill_count;
+            const char* in = body;
+            in = get(in, entry.sequence);
+            in = get(in, entry.timestamp_ns);
+            in = get(in, entry.requested);
+            in = get(in, entry.total);
+            in = get(in, entry.fees);
+            in = get(in, entry.optimality_gap);
+            in = get(in, side);
+            in = get(in, entry.flags);
+            in = get(in, reserved);
+            in = get(in, fill_count);
+            if (fill_count > (body_size - PLAN_BODY_SIZE) / sizeof(JournalFill)) throw std::runtime_error("Corrupt plan record: " + path);
+            entry.side = static_cast<OrderSide>(side);
+            entry.fills.reserve(fill_count);
+            for (uint32_t i = 0; i < fill_count; ++i) 
+            {
+                JournalFill fill;
+                in = get(in, fill);
+                auto venue = venues.find(fill.venue_id);
+                // The journal does not store fee rates; the plan's fees are in the PLAN record
+                entry.fills.emplace_back(venue != venues.end() ? venue->second : "venue#" + std::to_string(fill.venue_id),
+                                         fill.price, fill.volume, 0.0);
+            }
+            contents.entries.push_back(std::move(entry));
+        }
+    }
+    return contents;
+}
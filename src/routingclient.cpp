@@ -0,0 +1,114 @@
+#include "routingclient.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+RoutingClient::~RoutingClient()
+{
+    close();
+}
+
+void RoutingClient::connect_unix(const std::string& path)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    close();
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) 
+    {
+        std::string error = std::strerror(errno);
+        close();
+        throw std::runtime_error("Could not connect to " + path + ": " + error);
+    }
+}
+
+void RoutingClient::connect_tcp(uint16_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    close();
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) 
+    {
+        std::string error = std::strerror(errno);
+        close();
+        throw std::runtime_error("Could not connect to port " + std::to_string(port) + ": " + error);
+    }
+    int enable = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+void RoutingClient::send(const std::string& frames)
+{
+    size_t offset = 0;
+    while (offset < frames.size()) 
+    {
+        ssize_t sent = ::send(m_fd, frames.data() + offset, frames.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0) 
+        {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("send failed: ") + std::strerror(errno));
+        }
+        offset += static_cast<size_t>(sent);
+    }
+}
+
+void RoutingClient::finish_sending()
+{
+    if (m_fd >= 0 && shutdown(m_fd, SHUT_WR) < 0) 
+    {
+        throw std::runtime_error(std::string("shutdown failed: ") + std::strerror(errno));
+    }
+}
+
+bool RoutingClient::receive(WireHeader& header, std::string& payload)
+{
+    while (true) 
+    {
+        size_t buffered = m_input.size() - m_input_offset;
+        const char* frame = m_input.data() + m_input_offset;
+        if (decode_header(frame, buffered, header) && buffered - WIRE_HEADER_SIZE >= header.payload_length) 
+        {
+            payload.assign(frame + WIRE_HEADER_SIZE, header.payload_length);
+            m_input_offset += WIRE_HEADER_SIZE + header.payload_length;
+            return true;
+        }
+
+        // Compact before reading more so the buffer does not grow with the number of responses
+        m_input.erase(0, m_input_offset);
+        m_input_offset = 0;
+
+        char chunk[READ_CHUNK];
+        ssize_t received = recv(m_fd, chunk, sizeof(chunk), 0);
+        if (received == 0) return false;
+        if (received < 0) 
+        {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("recv failed: ") + std::strerror(errno));
+        }
+        m_input.append(chunk, static_cast<size_t>(received));
+    }
+}
+
+void RoutingClient::close()
+{
+    if (m_fd >= 0) 
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_input.clear();
+    m_input_offset = 0;
+}
@@ -0,0 +1,185 @@
+#include "routingengine.h"
+#include <stdexcept>
+
+RoutingEngine::RoutingEngine(SymbolRegistry& registry, size_t shard_count)
+    : m_registry(registry)
+{
+    shard_count = std::max<size_t>(shard_count, 1);
+
+    // Build every router up front: the registry creates them lazily and is not thread safe
+    for (SymbolId id = 0; id < m_registry.size(); ++id) 
+    {
+        m_registry.get_router(id);
+        m_symbol_locks.push_back(std::make_unique<std::shared_mutex>());
+    }
+
+    for (size_t i = 0; i < shard_count; ++i) 
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < shard_count; ++i) 
+    {
+        m_workers[i]->thread = std::thread(&RoutingEngine::run_worker, this, i);
+    }
+}
+
+RoutingEngine::~RoutingEngine()
+{
+    m_stopping = true;
+    for (auto& worker : m_workers) 
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+        worker->wake.notify_all();
+    }
+    for (auto& worker : m_workers) 
+    {
+        worker->thread.join();
+    }
+}
+
+size_t RoutingEngine::get_shard_count() const
+{
+    return m_workers.size();
+}
+
+size_t RoutingEngine::get_shard(SymbolId id) const
+{
+    return id % m_workers.size();
+}
+
+std::future<ExecutionPlan> RoutingEngine::submit_order(SymbolId id, Volume order_size, OrderSide side,
+                                                       RoutingAlgorithm algorithm, std::chrono::microseconds latency_budget)
+{
+    check_symbol(id);
+    auto task = std::make_shared<std::packaged_task<ExecutionPlan()>>(
+        [this, id, order_size, side, algorithm, latency_budget]() 
+        {
+            std::unique_lock<std::shared_mutex> lock(*m_symbol_locks[id]);
+            return m_registry.get_router(id).distribute_order(order_size, side, algorithm, latency_budget);
+        });
+    std::future<ExecutionPlan> result = task->get_future();
+    enqueue(get_shard(id), {[task]() { (*task)(); }, true});
+    return result;
+}
+
+std::future<ExecutionPlan> RoutingEngine::submit_quote(SymbolId id, Volume order_size, OrderSide side,
+                                                       RoutingAlgorithm algorithm, std::chrono::microseconds latency_budget)
+{
+    check_symbol(id);
+    auto task = std::make_shared<std::packaged_task<ExecutionPlan()>>(
+        [this, id, order_size, side, algorithm, latency_budget]() 
+        {
+            std::shared_lock<std::shared_mutex> lock(*m_symbol_locks[id]);
+            return m_registry.get_router(id).quote(order_size, side, algorithm, latency_budget);
+        });
+    std::future<ExecutionPlan> result = task->get_future();
+    enqueue(get_shard(id), {[task]() { (*task)(); }, false});
+    return result;
+}
+
+std::vector<ShardStats> RoutingEngine::get_shard_stats() const
+{
+    std::vector<ShardStats> stats;
+    for (const auto& worker : m_workers) 
+    {
+        stats.push_back({worker->orders_routed.load(), worker->quotes_served.load(), worker->quotes_stolen.load()});
+    }
+    return stats;
+}
+
+void RoutingEngine::enqueue(size_t shard, Task task)
+{
+    bool is_order = task.is_order;
+    Worker& owner = *m_workers[shard];
+    {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        (is_order ? owner.orders : owner.quotes).push_back(std::move(task));
+    }
+    owner.wake.notify_one();
+
+    // Nudge one other worker so an idle core can pick the quote up without waiting for its poll
+    if (!is_order && m_workers.size() > 1) 
+    {
+        size_t thief = m_next_thief.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        if (thief != shard) 
+        {
+            m_workers[thief]->wake.notify_one();
+        }
+    }
+}
+
+bool RoutingEngine::try_steal_quote(size_t thief, Task& task)
+{
+    for (size_t offset = 1; offset < m_workers.size(); ++offset) 
+    {
+        Worker& victim = *m_workers[(thief + offset) % m_workers.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.quotes.empty()) 
+        {
+            task = std::move(victim.quotes.front());
+            victim.quotes.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void RoutingEngine::run_worker(size_t index)
+{
+    Worker& worker = *m_workers[index];
+    while (true) 
+    {
+        Task task;
+        bool stolen = false;
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.wake.wait_for(lock, IDLE_POLL, [&]() 
+            {
+                return m_stopping || !worker.orders.empty() || !worker.quotes.empty();
+            });
+
+            // Orders first: they mutate the books, quotes should see the freshest state
+            if (!worker.orders.empty()) 
+            {
+                task = std::move(worker.orders.front());
+                worker.orders.pop_front();
+            } 
+            else if (!worker.quotes.empty()) 
+            {
+                task = std::move(worker.quotes.back());
+                worker.quotes.pop_back();
+            } 
+            else if (m_stopping) 
+            {
+                return;
+            }
+        }
+
+        if (!task.run) 
+        {
+            if (!try_steal_quote(index, task)) continue;
+            stolen = true;
+        }
+
+        task.run();
+        if (task.is_order) 
+        {
+            worker.orders_routed.fetch_add(1, std::memory_order_relaxed);
+        } 
+        else 
+        {
+            worker.quotes_served.fetch_add(1, std::memory_order_relaxed);
+            if (stolen) worker.quotes_stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void RoutingEngine::check_symbol(SymbolId id) const
+{
+    if (id >= m_symbol_locks.size()) 
+    {
+        throw std::out_of_range("Unknown symbol id: " + std::to_string(id));
+    }
+}
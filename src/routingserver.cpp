@@ -0,0 +1,370 @@
+#include "routingserver.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int MAX_EVENTS = 64;
+
+void set_non_blocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) 
+    {
+        throw std::runtime_error(std::string("fcntl failed: ") + std::strerror(errno));
+    }
+}
+
+std::runtime_error socket_error(const std::string& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+}
+
+RoutingServer::RoutingServer(SmartOrderRouter& router)
+    : m_router(router)
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0) throw socket_error("epoll_create1 failed");
+
+    m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wake_fd < 0) 
+    {
+        close(m_epoll_fd);
+        throw socket_error("eventfd failed");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wake_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &event);
+}
+
+RoutingServer::~RoutingServer()
+{
+    for (auto& [fd, connection] : m_connections) 
+    {
+        close(fd);
+    }
+    if (m_listen_fd >= 0) close(m_listen_fd);
+    if (!m_unix_path.empty()) unlink(m_unix_path.c_str());
+    close(m_wake_fd);
+    close(m_epoll_fd);
+}
+
+void RoutingServer::start_listening(int fd)
+{
+    if (listen(fd, SOMAXCONN) < 0) 
+    {
+        close(fd);
+        throw socket_error("listen failed");
+    }
+    set_non_blocking(fd);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    m_listen_fd = fd;
+}
+
+void RoutingServer::listen_unix(const std::string& path)
+{
+    if (m_listen_fd >= 0) throw std::runtime_error("Server is already listening");
+
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) throw socket_error("socket failed");
+    unlink(path.c_str());   // Stale socket left by a previous run
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) 
+    {
+        close(fd);
+        throw socket_error("bind failed for " + path);
+    }
+    m_unix_path = path;
+    start_listening(fd);
+}
+
+void RoutingServer::listen_tcp(uint16_t port)
+{
+    if (m_listen_fd >= 0) throw std::runtime_error("Server is already listening");
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) throw socket_error("socket failed");
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) 
+    {
+        close(fd);
+        throw socket_error("bind failed for port " + std::to_string(port));
+    }
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+    start_listening(fd);
+}
+
+uint16_t RoutingServer::get_port() const
+{
+    return m_port;
+}
+
+void RoutingServer::set_journal(PlanJournal* journal)
+{
+    m_journal = journal;
+}
+
+uint64_t RoutingServer::get_requests_served() const
+{
+    return m_requests_served.load(std::memory_order_relaxed);
+}
+
+void RoutingServer::stop()
+{
+    m_running.store(false);
+    uint64_t one = 1;
+    // write() is async-signal-safe, so stop() may be called from a signal handler
+    ssize_t written = write(m_wake_fd, &one, sizeof(one));
+    (void)written;
+}
+
+void RoutingServer::run()
+{
+    if (m_listen_fd < 0) throw std::runtime_error("Server is not listening");
+
+    m_running.store(true);
+    epoll_event events[MAX_EVENTS];
+    while (m_running.load()) 
+    {
+        int ready = epoll_wait(m_epoll_fd, events, MAX_EVENTS, -1);
+        if (ready < 0) 
+        {
+            if (errno == EINTR) continue;
+            throw socket_error("epoll_wait failed");
+        }
+
+        for (int i = 0; i < ready; ++i) 
+        {
+            int fd = events[i].data.fd;
+            if (fd == m_wake_fd) 
+            {
+                uint64_t value;
+                ssize_t drained = read(m_wake_fd, &value, sizeof(value));
+                (void)drained;
+                continue;
+            }
+            if (fd == m_listen_fd) 
+            {
+                accept_connections();
+                continue;
+            }
+
+            auto it = m_connections.find(fd);
+            if (it == m_connections.end()) continue;
+            Connection& connection = it->second;
+
+            bool open = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+            if (open && (events[i].events & EPOLLIN)) open = receive_input(connection);
+            if (open) open = flush_connection(connection);
+            // Frames held back by the output watermark resume as soon as the client drains responses
+            while (open && has_buffered_frame(connection) && pending_output(connection) < OUTPUT_HIGH_WATERMARK) 
+            {
+                open = process_frames(connection) && flush_connection(connection);
+            }
+            // A half-closed peer is done once its complete frames are answered and the answers are sent
+            if (open && connection.input_closed && !has_buffered_frame(connection) && pending_output(connection) == 0) 
+            {
+                open = false;
+            }
+            if (open) 
+            {
+                update_events(connection);
+            }
+            else 
+            {
+                close_connection(fd);
+            }
+        }
+    }
+}
+
+void RoutingServer::accept_connections()
+{
+    while (true) 
+    {
+        int fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;     // EAGAIN once the backlog is drained; other errors only drop that client
+
+        if (m_port != 0) 
+        {
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+
+        Connection& connection = m_connections[fd];
+        connection.fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        connection.events = EPOLLIN;
+    }
+}
+
+bool RoutingServer::receive_input(Connection& connection)
+{
+    char chunk[READ_CHUNK];
+    while (true) 
+    {
+        ssize_t received = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (received > 0) 
+        {
+            connection.input.append(chunk, static_cast<size_t>(received));
+            if (static_cast<size_t>(received) < sizeof(chunk)) return true;
+            continue;
+        }
+        if (received == 0) 
+        {
+            connection.input_closed = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+bool RoutingServer::has_buffered_frame(const Connection& connection) const
+{
+    size_t buffered = connection.input.size() - connection.input_offset;
+    WireHeader header;
+    if (!decode_header(connection.input.data() + connection.input_offset, buffered, header)) return false;
+    // An oversized frame counts as complete so process_frames() can reject it
+    return header.payload_length > WIRE_MAX_PAYLOAD || buffered - WIRE_HEADER_SIZE >= header.payload_length;
+}
+
+size_t RoutingServer::pending_output(const Connection& connection) const
+{
+    return connection.output.size() - connection.output_offset;
+}
+
+bool RoutingServer::process_frames(Connection& connection)
+{
+    // Answer every complete frame; a partial frame stays buffered until the rest arrives
+    while (has_buffered_frame(connection) && pending_output(connection) < OUTPUT_HIGH_WATERMARK) 
+    {
+        const char* frame = connection.input.data() + connection.input_offset;
+        WireHeader header;
+        decode_header(frame, WIRE_HEADER_SIZE, header);
+        if (header.payload_length > WIRE_MAX_PAYLOAD) return false;
+
+        handle_frame(connection, header, frame + WIRE_HEADER_SIZE);
+        connection.input_offset += WIRE_HEADER_SIZE + header.payload_length;
+    }
+    connection.input.erase(0, connection.input_offset);
+    connection.input_offset = 0;
+    return true;
+}
+
+void RoutingServer::handle_frame(Connection& connection, const WireHeader& header, const char* payload)
+{
+    m_requests_served.fetch_add(1, std::memory_order_relaxed);
+    try 
+    {
+        switch (static_cast<WireRequestType>(header.code)) 
+        {
+            case WireRequestType::DISTRIBUTE:
+            case WireRequestType::QUOTE:
+            {
+                WireOrderRequest request;
+                if (!decode_order_request(payload, header.payload_length, request)) break;
+                std::chrono::microseconds budget = (request.latency_budget_us == WIRE_NO_LATENCY_BUDGET)
+                    ? NO_LATENCY_BUDGET
+                    : std::chrono::microseconds(static_cast<int64_t>(std::min<uint64_t>(request.latency_budget_us, INT64_MAX)));
+                ExecutionPlan plan = (static_cast<WireRequestType>(header.code) == WireRequestType::DISTRIBUTE)
+                    ? m_router.distribute_order(request.size, request.side, request.algorithm, budget)
+                    : m_router.quote(request.size, request.side, request.algorithm, budget);
+                if (m_journal && static_cast<WireRequestType>(header.code) == WireRequestType::DISTRIBUTE) 
+                {
+                    m_journal->record(plan);
+                }
+                encode_plan_response(connection.output, header.request_id, plan);
+                return;
+            }
+            case WireRequestType::LIQUIDITY:
+            {
+                OrderSide side;
+                if (!decode_liquidity_request(payload, header.payload_length, side)) break;
+                encode_liquidity_response(connection.output, header.request_id, m_router.get_liquidity(side));
+                return;
+            }
+        }
+        encode_error_response(connection.output, header.request_id, WireStatus::BAD_REQUEST);
+    } 
+    catch (const std::exception&) 
+    {
+        encode_error_response(connection.output, header.request_id, WireStatus::SERVER_ERROR);
+    }
+}
+
+bool RoutingServer::flush_connection(Connection& connection)
+{
+    while (connection.output_offset < connection.output.size()) 
+    {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+                            connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent > 0) 
+        {
+            connection.output_offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+    if (connection.output_offset == connection.output.size()) 
+    {
+        connection.output.clear();
+        connection.output_offset = 0;
+    }
+    return true;
+}
+
+void RoutingServer::update_events(Connection& connection)
+{
+    size_t pending = pending_output(connection);
+    uint32_t events = 0;
+    if (pending < OUTPUT_HIGH_WATERMARK && !connection.input_closed) events |= EPOLLIN;    // EOF stays readable
+    if (pending > 0) events |= EPOLLOUT;
+    if (events == connection.events) return;
+
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.events = events;
+}
+
+void RoutingServer::close_connection(int fd)
+{
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_connections.erase(fd);
+}
@@ -1,12 +1,17 @@
 #include "smartorderrouter.h"
+#include "costcurves.h"
 #include <unordered_set>
 #include <algorithm>
 #include <iomanip>
+#include <tuple>
 
 constexpr double EPSILON = 1e-6;
 
 SmartOrderRouter::SmartOrderRouter(std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>> order_books)
-    : m_order_books(std::make_unique<std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>>>(std::move(order_books))) {}
+    : m_order_books(std::make_unique<std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>>>(std::move(order_books))),
+      m_optimizer_cache(std::make_unique<OptimizerCache>()),
+      m_quote_ladder(std::make_unique<QuoteLadder>()),
+      m_adaptive_model(std::make_unique<AdaptiveModel>()) {}
 
 Price effective_price(Price original_price, OrderSide side, double fee) 
 {
@@ -31,14 +36,158 @@ double SmartOrderRouter::get_largest_min_lot_size(
     return largest_min;
 }
 
-ExecutionPlan SmartOrderRouter::distribute_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm) const
+ExecutionPlan SmartOrderRouter::distribute_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                                std::chrono::microseconds latency_budget) const
 {
-    auto order_books_ptr = std::shared_ptr<const std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>>>(
-        m_order_books.get(),
-        [](auto*) {}
-    );
-    
-    ExecutionPlan execution_plan({}, order_books_ptr, side, order_size);
+    return route_order(order_size, side, algorithm, latency_budget, true).commit();
+}
+
+LiquidityReservation SmartOrderRouter::reserve_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                                     std::chrono::microseconds latency_budget) const
+{
+    return route_order(order_size, side, algorithm, latency_budget, true);
+}
+
+ExecutionPlan SmartOrderRouter::quote(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                     std::chrono::microseconds latency_budget) const
+{
+    if (latency_budget == NO_LATENCY_BUDGET) 
+    {
+        // Index of the rung quoting this order, SIZE_MAX when the ladder has none
+        auto find_rung = [&](const QuoteLadderSide& ladder) 
+        {
+            auto rung = std::lower_bound(ladder.sizes.begin(), ladder.sizes.end(), order_size - EPSILON);
+            bool found = algorithm == ladder.algorithm && rung != ladder.sizes.end() && std::abs(*rung - order_size) <= EPSILON;
+            return found ? static_cast<size_t>(rung - ladder.sizes.begin()) : SIZE_MAX;
+        };
+        std::shared_ptr<const QuoteLadderSide> ladder = std::atomic_load(&m_quote_ladder->sides[static_cast<size_t>(side)]);
+        if (ladder && find_rung(*ladder) != SIZE_MAX) 
+        {
+            // While another thread rebuilds the side, routing this one size is cheaper than waiting for all of them
+            ladder = refresh_quote_ladder(side, false);
+            size_t rung = ladder ? find_rung(*ladder) : SIZE_MAX;
+            if (ladder && rung < ladder->plans.size()) return ladder->plans[rung];
+        }
+    }
+    return route_order(order_size, side, algorithm, latency_budget, false).get_plan();
+}
+
+std::vector<uint64_t> SmartOrderRouter::get_side_versions(OrderSide side) const
+{
+    std::vector<uint64_t> versions;
+    versions.reserve(m_order_books->size());
+    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    {
+        versions.push_back(order_book->get_side_version(side));
+    }
+    return versions;
+}
+
+std::shared_ptr<const SmartOrderRouter::QuoteLadderSide> SmartOrderRouter::refresh_quote_ladder(OrderSide side, bool wait) const
+{
+    QuoteLadder& ladder = *m_quote_ladder;
+    size_t index = static_cast<size_t>(side);
+    // Versions are read before the walk, so a change racing with the rebuild triggers another one
+    std::vector<uint64_t> versions = get_side_versions(side);
+    std::shared_ptr<const QuoteLadderSide> current = std::atomic_load(&ladder.sides[index]);
+    if (!current || current->sizes.empty()) return nullptr;
+    if (versions == current->side_versions) 
+    {
+        ladder.hits.fetch_add(1, std::memory_order_relaxed);
+        return current;
+    }
+
+    std::unique_lock<std::mutex> rebuilding(ladder.rebuilding[index], std::defer_lock);
+    if (wait) rebuilding.lock();
+    else if (!rebuilding.try_lock()) return nullptr;
+    // Another thread may have finished a rebuild between the version check and the lock
+    current = std::atomic_load(&ladder.sides[index]);
+    if (!current || current->sizes.empty()) return nullptr;
+    versions = get_side_versions(side);
+    if (versions == current->side_versions) 
+    {
+        ladder.hits.fetch_add(1, std::memory_order_relaxed);
+        return current;
+    }
+
+    ladder.misses.fetch_add(1, std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    auto rebuilt = std::make_shared<QuoteLadderSide>();
+    rebuilt->sizes = current->sizes;
+    rebuilt->algorithm = current->algorithm;
+    rebuilt->side_versions = std::move(versions);
+    rebuilt->plans.reserve(rebuilt->sizes.size());
+    for (Volume size : rebuilt->sizes) 
+    {
+        rebuilt->plans.push_back(route_order(size, side, rebuilt->algorithm, NO_LATENCY_BUDGET, false).get_plan());
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    ladder.refresh_time_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    ladder.last_refresh_time_ns.store(elapsed.count(), std::memory_order_relaxed);
+    SOR_LOG(LogLevel::DEBUG, "Quote ladder rebuilt: Side = {}, Sizes = {}, Time = {} ns",
+            static_cast<int>(side), rebuilt->sizes.size(), elapsed.count());
+
+    // set_quote_ladder may have replaced the side meanwhile; its configuration wins
+    std::shared_ptr<const QuoteLadderSide> published = rebuilt;
+    if (!std::atomic_compare_exchange_strong(&ladder.sides[index], &current, published)) return nullptr;
+    return published;
+}
+
+void SmartOrderRouter::set_quote_ladder(std::vector<Volume> sizes, RoutingAlgorithm algorithm)
+{
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end(), [](Volume a, Volume b) { return b - a <= EPSILON; }), sizes.end());
+
+    auto empty = std::make_shared<QuoteLadderSide>();
+    empty->sizes = std::move(sizes);
+    empty->algorithm = algorithm;
+    for (size_t side = 0; side < 2; ++side) 
+    {
+        std::atomic_store(&m_quote_ladder->sides[side], std::shared_ptr<const QuoteLadderSide>(empty));
+    }
+    m_quote_ladder->hits.store(0, std::memory_order_relaxed);
+    m_quote_ladder->misses.store(0, std::memory_order_relaxed);
+    m_quote_ladder->refresh_time_ns.store(0, std::memory_order_relaxed);
+    m_quote_ladder->last_refresh_time_ns.store(0, std::memory_order_relaxed);
+}
+
+std::vector<LadderQuote> SmartOrderRouter::get_quote_ladder(OrderSide side) const
+{
+    std::shared_ptr<const QuoteLadderSide> current = refresh_quote_ladder(side, true);
+    if (!current) return {};
+    std::vector<LadderQuote> ladder;
+    ladder.reserve(current->sizes.size());
+    for (size_t i = 0; i < current->sizes.size(); ++i) 
+    {
+        const ExecutionPlan& plan = current->plans[i];
+        Volume filled = 0.0;
+        for (const FillOrder& fill : plan.get_plan()) 
+        {
+            filled += fill.volume;
+        }
+        ladder.push_back({current->sizes[i], filled, plan.get_total(), plan.get_average_effective_price()});
+    }
+    return ladder;
+}
+
+QuoteLadderStats SmartOrderRouter::get_quote_ladder_stats() const
+{
+    QuoteLadderStats stats;
+    stats.hits = m_quote_ladder->hits.load(std::memory_order_relaxed);
+    stats.misses = m_quote_ladder->misses.load(std::memory_order_relaxed);
+    stats.refresh_time = std::chrono::nanoseconds(m_quote_ladder->refresh_time_ns.load(std::memory_order_relaxed));
+    stats.last_refresh_time = std::chrono::nanoseconds(m_quote_ladder->last_refresh_time_ns.load(std::memory_order_relaxed));
+    return stats;
+}
+
+LiquidityReservation SmartOrderRouter::route_order(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                                   std::chrono::microseconds latency_budget, bool claim_liquidity) const
+{
+    auto deadline = (latency_budget == NO_LATENCY_BUDGET)
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() + latency_budget;
+
+    ExecutionPlan execution_plan(side, order_size);
 
     Volume remaining_size = order_size;
     Volume absolute_min_lot_size = order_size;
@@ -55,32 +204,125 @@ ExecutionPlan SmartOrderRouter::distribute_order(Volume order_size, OrderSide si
     }
 
     std::priority_queue<BestOrder, std::vector<BestOrder>, Comparator> best_orders(comparator);
+    std::vector<VenueCursor> cursors;
+    cursors.reserve(m_order_books->size());
+    std::vector<LiquidityClaim> claims;
 
-    DEBUG_LOG("Initial Order: Size = " << order_size << ", Type = " << ((side == OrderSide::BUY) ? "Buy" : "Sell"));
+    // Levels are never inserted or erased under a read lock; volumes move only through claims
+    std::vector<std::shared_lock<std::shared_mutex>> book_locks;
+    book_locks.reserve(m_order_books->size());
+    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    {
+        book_locks.push_back(order_book->read_lock());
+    }
+
+    // Moves a cursor to the next level in priority order (ascending asks, descending bids),
+    // skipping levels fully claimed by other in-flight plans
+    auto advance_cursor = [side](VenueCursor& cursor) 
+    {
+        do 
+        {
+            if (side == OrderSide::BUY) 
+            {
+                ++cursor.level;
+                cursor.exhausted = (cursor.level == cursor.levels->end());
+            } 
+            else 
+            {
+                cursor.exhausted = (cursor.level == cursor.levels->begin());
+                if (!cursor.exhausted) --cursor.level;
+            }
+            if (!cursor.exhausted) cursor.level_volume = cursor.level->second.load();
+        } while (!cursor.exhausted && cursor.level_volume <= 0.0);
+    };
+
+    auto reset_cursor = [side, &advance_cursor](VenueCursor& cursor) 
+    {
+        cursor.exhausted = cursor.levels->empty();
+        if (cursor.exhausted) return;
+        cursor.level = (side == OrderSide::BUY) ? cursor.levels->begin() : --cursor.levels->end();
+        cursor.level_volume = cursor.level->second.load();
+        if (cursor.level_volume <= 0.0) advance_cursor(cursor);
+    };
+
+    auto push_cursor = [&](const ExchangeName& exchange_name, const VenueCursor& cursor, size_t venue_index) 
+    {
+        Price price = cursor.level->first;
+        double fee = cursor.book->get_taker_fee();
+        best_orders.push({
+            exchange_name,
+            effective_price(price, side, fee),
+            cursor.level_volume,
+            price,
+            fee,
+            venue_index
+        });
+    };
+
+    // What the greedy walk would still fill of `residual` from the current cursors, without claiming anything
+    auto greedy_finish = [&](Volume residual) 
+    {
+        std::vector<FillOrder> fills;
+        std::vector<VenueCursor> walk = cursors;
+        while (true) 
+        {
+            VenueCursor* best = nullptr;
+            Price best_price = 0.0;
+            for (VenueCursor& candidate : walk) 
+            {
+                if (candidate.exhausted || candidate.book->get_min_order_size() > residual) continue;
+                Price price = effective_price(candidate.level->first, side, candidate.book->get_taker_fee());
+                if (!best || (side == OrderSide::BUY ? price < best_price : price > best_price)) 
+                {
+                    best = &candidate;
+                    best_price = price;
+                }
+            }
+            if (!best) break;
+
+            Volume min_order_size = best->book->get_min_order_size();
+            Volume fill_quantity = std::floor((std::min(best->level_volume, residual) / min_order_size) + EPSILON) * min_order_size;
+            if (fill_quantity > 0) 
+            {
+                fills.emplace_back(best->book->get_exchange_name(), best->level->first, fill_quantity, best->book->get_taker_fee());
+                residual -= fill_quantity;
+            }
+            best->level_volume -= fill_quantity;
+            if (best->level_volume <= min_order_size) advance_cursor(*best);
+        }
+        return fills;
+    };
+    bool adaptive_declined = false;
+    bool optimizer_abandoned = false;
+
+    // Re-reads the levels under every cursor after claims were lost to other plans
+    auto refresh_cursors = [&]() 
+    {
+        for (VenueCursor& venue_cursor : cursors) 
+        {
+            if (venue_cursor.exhausted) continue;
+            venue_cursor.level_volume = venue_cursor.level->second.load();
+            if (venue_cursor.level_volume <= 0.0) advance_cursor(venue_cursor);
+        }
+    };
+
+    SOR_LOG(LogLevel::DEBUG, "Initial Order: Size = {}, Type = {}", order_size, (side == OrderSide::BUY) ? "Buy" : "Sell");
 
     // Initialize priority queue with best orders from each exchange
     for (const auto& [exchange_name, order_book] : *m_order_books) {
         const auto& order_side = (side == OrderSide::BUY) ? order_book->get_asks() : order_book->get_bids();
 
-        if (!order_side.empty()) {
-            auto best_order = (side == OrderSide::BUY) ? order_side.begin() : --order_side.end();
-            Price price = best_order->first;
-            Volume volume = best_order->second;
-            double fee = order_book->get_taker_fee();
-            
+        VenueCursor cursor{order_book.get(), &order_side, order_side.end(), 0.0, true};
+        reset_cursor(cursor);
+        if (!cursor.exhausted) {
             absolute_min_lot_size = std::min(absolute_min_lot_size, order_book->get_min_order_size());
+            push_cursor(exchange_name, cursor, cursors.size());
 
-            best_orders.push({
-                exchange_name,
-                effective_price(price, side, fee),
-                volume,
-                price,
-                fee
-            });
-
-            DEBUG_LOG("Added order to queue: Exchange = " << exchange_name << ", Effective Price = " << effective_price(price, side, fee) << ", Volume = " << volume
-             << ", MinLotSize = " << order_books_ptr->at(exchange_name)->get_min_order_size() << ", Original Price = " << price << ", Fee = " << fee);
+            SOR_LOG(LogLevel::TRACE, "Added order to queue: Exchange = {}, Effective Price = {}, Volume = {}, MinLotSize = {}, Original Price = {}, Fee = {}",
+                    exchange_name, effective_price(cursor.level->first, side, order_book->get_taker_fee()), cursor.level_volume,
+                    order_book->get_min_order_size(), cursor.level->first, order_book->get_taker_fee());
         }
+        cursors.push_back(cursor);
     }
 
     Volume largest_min_lot_size = get_largest_min_lot_size(best_orders);
@@ -89,361 +331,885 @@ ExecutionPlan SmartOrderRouter::distribute_order(Volume order_size, OrderSide si
     {
 
         auto best_order = best_orders.top();
+        VenueCursor& cursor = cursors[best_order.venue_index];
 
-        DEBUG_LOG("Processing order: Exchange = " << best_order.exchange_name << ", Effective Price = " << best_order.effective_price << ", Volume = " << best_order.volume
-                  << ", MinLotSize = " << m_order_books->at(best_order.exchange_name)->get_min_order_size() << ", Original Price = " << best_order.original_price << ", Fee = " << best_order.fee);
+        SOR_LOG(LogLevel::TRACE, "Processing order: Exchange = {}, Effective Price = {}, Volume = {}, MinLotSize = {}, Original Price = {}, Fee = {}",
+                best_order.exchange_name, best_order.effective_price, best_order.volume,
+                cursor.book->get_min_order_size(), best_order.original_price, best_order.fee);
 
         Volume fill_quantity = std::min(best_order.volume, remaining_size);
-        Volume min_order_size = m_order_books->at(best_order.exchange_name)->get_min_order_size();
+        Volume min_order_size = cursor.book->get_min_order_size();
 
 
         fill_quantity = std::floor((fill_quantity / min_order_size) + EPSILON) * min_order_size;
 
-        if (fill_quantity > 0) 
+        // Check if we should switch to optimization approach (if we're close to min_order_sizes)
+        bool switch_to_optimizer = fill_quantity > 0 &&
+            !optimizer_abandoned &&
+            (algorithm == RoutingAlgorithm::HYBRID || (algorithm == RoutingAlgorithm::ADAPTIVE && !adaptive_declined)) &&
+            remaining_size - fill_quantity > EPSILON &&
+            remaining_size - fill_quantity < largest_min_lot_size;
+
+        // ADAPTIVE asks its cost model once; when declined, the order finishes greedily
+        AdaptiveDecision decision;
+        if (switch_to_optimizer && algorithm == RoutingAlgorithm::ADAPTIVE) 
+        {
+            decision = decide_adaptive(remaining_size, side, cursors, greedy_finish(remaining_size));
+            switch_to_optimizer = decision.optimize;
+            adaptive_declined = !decision.optimize;
+        }
+
+        if (switch_to_optimizer) 
         {
-            // Check if we should switch to optimization approach (if we're close to min_order_sizes)
-            if (algorithm == RoutingAlgorithm::HYBRID && 
-                remaining_size - fill_quantity > EPSILON &&
-                remaining_size - fill_quantity < largest_min_lot_size) 
-            {               
-                std::vector<FillOrder> optimized_fills = distribute_order_optimized(remaining_size, side, best_orders);
-                for (const FillOrder& fill : optimized_fills)
+            auto optimizer_start = std::chrono::steady_clock::now();
+            OptimizerResult optimized = optimize_residual(remaining_size, side, cursors, deadline);
+            for (int attempt = 1; claim_liquidity && !claim_optimized_fills(optimized.fills, side, cursors, claims); ++attempt) 
+            {
+                refresh_cursors();
+                if (attempt == OPTIMIZER_CLAIM_ATTEMPTS) 
                 {
-                    execution_plan.add_fill(fill);
-                    remaining_size -= fill.volume;
+                    SOR_LOG(LogLevel::WARNING, "Optimizer fills kept being claimed concurrently, finishing residual {} greedily", remaining_size);
+                    optimizer_abandoned = true;
+                    break;
                 }
-                break;
+                optimized = optimize_residual(remaining_size, side, cursors, deadline);
             }
 
-            execution_plan.add_fill(FillOrder(best_order.exchange_name, best_order.original_price, fill_quantity));
+            if (optimizer_abandoned) 
+            {
+                // The queue still ranks the levels seen before the conflicts; rebuild it from the refreshed cursors
+                best_orders = std::priority_queue<BestOrder, std::vector<BestOrder>, Comparator>(comparator);
+                for (size_t venue = 0; venue < cursors.size(); ++venue) 
+                {
+                    if (!cursors[venue].exhausted) push_cursor(cursors[venue].book->get_exchange_name(), cursors[venue], venue);
+                }
+                largest_min_lot_size = get_largest_min_lot_size(best_orders);
+                continue;
+            }
 
-            DEBUG_LOG("Added to execution plan: Exchange = " << best_order.exchange_name << ", Price = " << best_order.original_price << ", Quantity = " << fill_quantity);
-            remaining_size -= fill_quantity;
-            DEBUG_LOG("Remaining size to fill: " << remaining_size);
+            if (algorithm == RoutingAlgorithm::ADAPTIVE) 
+            {
+                record_adaptive_run(decision, side, optimized.fills, std::chrono::steady_clock::now() - optimizer_start);
+            }
 
-        } 
-        else 
+            for (const FillOrder& fill : optimized.fills)
+            {
+                execution_plan.add_fill(fill);
+                remaining_size -= fill.volume;
+            }
+            execution_plan.set_optimality(optimized.proven_optimal, optimized.optimality_gap, optimized.volume_gap);
+            execution_plan.set_coarsening_error_bound(optimized.coarsening_error_bound);
+            break;
+        }
+
+        // Levels left at or below the min order size are dropped, so their remainder goes with the fill
+        Volume taken = (cursor.level_volume - fill_quantity <= min_order_size) ? cursor.level_volume : fill_quantity;
+        if (claim_liquidity && taken > 0) 
         {
-            DEBUG_LOG("Skipping order from " << best_order.exchange_name << " because fill_quantity <= 0." << "\nRemaining size to fill: " << remaining_size);
+            Volume observed = cursor.level_volume;
+            if (!cursor.book->try_claim(side, cursor.level, observed, taken)) 
+            {
+                // Another plan changed the level first: re-read it and let the queue re-rank it
+                SOR_LOG(LogLevel::DEBUG, "Claim lost on {} at {}, observed volume {}", best_order.exchange_name, best_order.original_price, observed);
+                best_orders.pop();
+                cursor.level_volume = observed;
+                if (cursor.level_volume <= 0.0) advance_cursor(cursor);
+                if (cursor.exhausted) 
+                {
+                    largest_min_lot_size = get_largest_min_lot_size(best_orders);
+                } 
+                else 
+                {
+                    push_cursor(best_order.exchange_name, cursor, best_order.venue_index);
+                }
+                continue;
+            }
+            claims.push_back({cursor.book, &cursor.level->second, taken, cursor.level->first, side});
         }
 
-        // Update order book
-        auto& order_book = m_order_books->at(best_order.exchange_name);
-        if (side == OrderSide::BUY) 
+        if (fill_quantity > 0) 
         {
-            order_book->reduce_ask_volume(best_order.original_price, fill_quantity);
+            execution_plan.add_fill(FillOrder(best_order.exchange_name, best_order.original_price, fill_quantity, best_order.fee));
+
+            remaining_size -= fill_quantity;
+            SOR_LOG(LogLevel::DEBUG, "Added to execution plan: Exchange = {}, Price = {}, Quantity = {}, Remaining = {}",
+                    best_order.exchange_name, best_order.original_price, fill_quantity, remaining_size);
+
         } 
         else 
         {
-            order_book->reduce_bid_volume(best_order.original_price, fill_quantity);
+            SOR_LOG(LogLevel::TRACE, "Skipping order from {} because fill_quantity <= 0, Remaining = {}", best_order.exchange_name, remaining_size);
+        }
+
+        cursor.level_volume -= fill_quantity;
+        if (cursor.level_volume <= min_order_size) 
+        {
+            advance_cursor(cursor);
         }
 
         best_orders.pop();
 
         // Add next order from same exchange if available
-        const auto& order_side = (side == OrderSide::BUY) ? order_book->get_asks() : order_book->get_bids();
-        if (order_side.empty()) 
+        if (cursor.exhausted) 
         {
             largest_min_lot_size = get_largest_min_lot_size(best_orders);
         }
 
-        if (!order_side.empty() && order_book->get_min_order_size() <= remaining_size) 
+        if (!cursor.exhausted && min_order_size <= remaining_size) 
         {
-            auto next_order = (side == OrderSide::BUY) ? order_side.begin() : --order_side.end();
-            Price price = next_order->first;
-            Volume volume = next_order->second;
-            double fee = order_book->get_taker_fee();
+            push_cursor(best_order.exchange_name, cursor, best_order.venue_index);
 
-            best_orders.push({
-                best_order.exchange_name,
-                effective_price(price, side, fee),
-                volume,
-                price,
-                fee
-            });
-
-            DEBUG_LOG("Added next order to queue: Exchange = " << best_order.exchange_name << ", Effective Price = " << effective_price(price, side, fee) << ", Volume = " << volume
-                      << ", Original Price = " << price  << ", Fee = " << fee);
+            SOR_LOG(LogLevel::TRACE, "Added next order to queue: Exchange = {}, Effective Price = {}, Volume = {}, Original Price = {}, Fee = {}",
+                    best_order.exchange_name, effective_price(cursor.level->first, side, cursor.book->get_taker_fee()), cursor.level_volume,
+                    cursor.level->first, cursor.book->get_taker_fee());
         }        
     }
 
-    return execution_plan;
+    // Depth limits cap the plan at the routing windows; say how much of the shortfall they held back
+    if (remaining_size > EPSILON) 
+    {
+        Volume cold_volume = 0.0;
+        for (const auto& [exchange_name, order_book] : *m_order_books) 
+        {
+            cold_volume += order_book->get_cold_volume(side);
+        }
+        if (cold_volume > 0.0) 
+        {
+            execution_plan.set_depth_limited_volume(std::min(remaining_size, cold_volume));
+            SOR_LOG(LogLevel::DEBUG, "Depth limits held back {} of the unfilled {}", std::min(remaining_size, cold_volume), remaining_size);
+        }
+    }
+
+    return LiquidityReservation(std::move(execution_plan), std::move(claims));
+}
+
+bool SmartOrderRouter::claim_optimized_fills(const std::vector<FillOrder>& fills, OrderSide side,
+                                             const std::vector<VenueCursor>& cursors, std::vector<LiquidityClaim>& claims) const
+{
+    // All or nothing: a plan missing one of its fills is no longer the optimum
+    size_t first_claim = claims.size();
+    for (const FillOrder& fill : fills) 
+    {
+        auto cursor = std::find_if(cursors.begin(), cursors.end(), [&](const VenueCursor& candidate) 
+        {
+            return candidate.book->get_exchange_name() == fill.exchange_name;
+        });
+        auto level = cursor->levels->find(fill.price);
+        bool claimed = false;
+        if (level != cursor->levels->end()) 
+        {
+            Volume min_order_size = cursor->book->get_min_order_size();
+            Volume observed = level->second.load();
+            while (observed >= fill.volume - EPSILON) 
+            {
+                Volume taken = (observed - fill.volume <= min_order_size) ? observed : fill.volume;
+                if (cursor->book->try_claim(side, level, observed, taken)) 
+                {
+                    claims.push_back({cursor->book, &level->second, taken, level->first, side});
+                    claimed = true;
+                    break;
+                }
+            }
+        }
+
+        if (!claimed) 
+        {
+            SOR_LOG(LogLevel::DEBUG, "Optimizer fill on {} at {} was claimed concurrently", fill.exchange_name, fill.price);
+            for (size_t i = first_claim; i < claims.size(); ++i) 
+            {
+                claims[i].book->release_claim(claims[i]);
+            }
+            claims.resize(first_claim);
+            return false;
+        }
+    }
+    return true;
+}
+
+SmartOrderRouter::BookState SmartOrderRouter::get_book_state(const std::vector<VenueCursor>& cursors) const
+{
+    BookState state;
+    state.reserve(cursors.size());
+    for (const VenueCursor& cursor : cursors) 
+    {
+        if (cursor.exhausted) 
+        {
+            state.emplace_back(cursor.book->get_version(), 0.0, -1.0);
+        } 
+        else 
+        {
+            state.emplace_back(cursor.book->get_version(), cursor.level->first, cursor.level_volume);
+        }
+    }
+    return state;
 }
 
-std::vector<FillOrder> SmartOrderRouter::distribute_order_optimized(Volume remaining_size,
-                                                                    OrderSide side,
-                                                                    const std::priority_queue<BestOrder, std::vector<BestOrder>, Comparator>& best_orders
-                                                                ) const 
+OptimizerResult SmartOrderRouter::optimize_residual(Volume remaining_size,
+                                                    OrderSide side,
+                                                    const std::vector<VenueCursor>& cursors,
+                                                    std::chrono::steady_clock::time_point deadline
+                                                   ) const
 {
-    // Collect candidate lots for optimal solution
+    auto key = std::make_pair(side, std::llround(remaining_size / EPSILON));
+    BookState book_state = get_book_state(cursors);
+
+    {
+        std::lock_guard<std::mutex> lock(m_optimizer_cache->mutex);
+        auto& entries = m_optimizer_cache->entries;
+        auto& stats = m_optimizer_cache->stats;
+        auto cached = entries.find(key);
+        if (cached != entries.end()) 
+        {
+            if (cached->second.book_state == book_state) 
+            {
+                ++stats.hits;
+                stats.saved_latency += cached->second.compute_time;
+                SOR_LOG(LogLevel::DEBUG, "Optimizer cache hit: Residual = {}", remaining_size);
+                return cached->second.result;
+            }
+            ++stats.invalidations;
+            entries.erase(cached);
+        }
+        ++stats.misses;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    OptimizerResult result = distribute_order_optimized(remaining_size, side, cursors, deadline);
+    auto compute_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    // Budget-truncated results are not cached: a later call may have the time to prove optimality
+    if (result.proven_optimal) 
+    {
+        std::lock_guard<std::mutex> lock(m_optimizer_cache->mutex);
+        auto& entries = m_optimizer_cache->entries;
+        if (entries.size() >= OPTIMIZER_CACHE_CAPACITY) 
+        {
+            // Drop entries built on other book states first, everything if none qualifies
+            for (auto it = entries.begin(); it != entries.end();) 
+            {
+                it = (it->second.book_state != book_state) ? entries.erase(it) : std::next(it);
+            }
+            if (entries.size() >= OPTIMIZER_CACHE_CAPACITY) 
+            {
+                entries.clear();
+            }
+        }
+        entries[key] = {std::move(book_state), result, compute_time};
+    }
+    return result;
+}
+
+void SmartOrderRouter::set_parallel_optimizer_threshold(size_t min_lots)
+{
+    m_parallel_optimizer_min_lots = min_lots;
+}
+
+void SmartOrderRouter::set_optimizer_coarsening(const OptimizerCoarsening& coarsening)
+{
+    m_optimizer_coarsening = coarsening;
+    clear_optimizer_cache();
+}
+
+OptimizerCacheStats SmartOrderRouter::get_optimizer_cache_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_optimizer_cache->mutex);
+    return m_optimizer_cache->stats;
+}
+
+void SmartOrderRouter::clear_optimizer_cache()
+{
+    std::lock_guard<std::mutex> lock(m_optimizer_cache->mutex);
+    m_optimizer_cache->entries.clear();
+    m_optimizer_cache->stats = OptimizerCacheStats();
+}
+
+Price SmartOrderRouter::get_adaptive_objective(const std::vector<FillOrder>& fills, Volume residual, OrderSide side,
+                                               Price reference_price, double shortfall_penalty_bps) const
+{
+    const double sign = (side == OrderSide::BUY) ? 1.0 : -1.0;
+    Price objective = 0.0;
+    for (const FillOrder& fill : fills) 
+    {
+        objective += sign * fill.volume * effective_price(fill.price, side, fill.fee_rate);
+        residual -= fill.volume;
+    }
+    Price shortfall_price = sign * reference_price + reference_price * shortfall_penalty_bps / 10000.0;
+    return objective + std::max(0.0, residual) * shortfall_price;
+}
+
+SmartOrderRouter::AdaptiveDecision SmartOrderRouter::decide_adaptive(Volume remaining_size, OrderSide side,
+                                                                     const std::vector<VenueCursor>& cursors,
+                                                                     const std::vector<FillOrder>& greedy_finish) const
+{
+    AdaptiveDecision decision;
+    decision.residual = remaining_size;
+
+    // Features: the optimizer collects up to residual / min_size lots per venue, and can at best fill
+    // the whole residual at the best effective price on offer
+    size_t lots = 0;
+    bool have_price = false;
+    for (const VenueCursor& cursor : cursors) 
+    {
+        if (cursor.exhausted) continue;
+        lots += static_cast<size_t>(remaining_size / cursor.book->get_min_order_size() + EPSILON);
+        Price price = effective_price(cursor.level->first, side, cursor.book->get_taker_fee());
+        if (!have_price || (side == OrderSide::BUY ? price < decision.reference_price : price > decision.reference_price)) 
+        {
+            decision.reference_price = price;
+            have_price = true;
+        }
+    }
+    while (decision.bucket + 1 < ADAPTIVE_BUCKETS && (size_t(2) << decision.bucket) <= lots) ++decision.bucket;
+
+    std::lock_guard<std::mutex> lock(m_adaptive_model->mutex);
+    const AdaptiveHybridConfig& config = m_adaptive_model->config;
+    AdaptiveModel::Bucket& bucket = m_adaptive_model->buckets[decision.bucket];
+    decision.greedy_objective = get_adaptive_objective(greedy_finish, remaining_size, side, decision.reference_price,
+                                                       config.shortfall_penalty_bps);
+    Price lower_bound = (side == OrderSide::BUY ? 1.0 : -1.0) * remaining_size * decision.reference_price;
+    Price best_case = decision.greedy_objective - lower_bound;
+    decision.predicted_runtime_us = bucket.runtime_us;
+    decision.predicted_benefit = std::min(best_case, bucket.benefit_bps / 10000.0 * remaining_size * decision.reference_price);
+
+    ++m_adaptive_model->stats.decisions;
+    if (best_case <= EPSILON) 
+    {
+        // Greedy already fills everything at the best price: nothing to gain
+        decision.optimize = false;
+    }
+    else if (bucket.runs < config.warmup_runs) 
+    {
+        decision.optimize = decision.exploring = true;
+    }
+    else if (decision.predicted_benefit >= decision.predicted_runtime_us * config.latency_cost_per_us) 
+    {
+        decision.optimize = true;
+    }
+    else if (++bucket.declined_since_run >= std::max<uint64_t>(config.explore_interval, 1)) 
+    {
+        decision.optimize = decision.exploring = true;
+    }
+
+    if (!decision.optimize) ++m_adaptive_model->stats.declined;
+    SOR_LOG(LogLevel::DEBUG, "Adaptive switch: Lots ~ {}, Predicted benefit = {}, Predicted runtime = {} us, {}",
+            lots, decision.predicted_benefit, decision.predicted_runtime_us,
+            decision.optimize ? (decision.exploring ? "exploring" : "optimizing") : "finishing greedily");
+    return decision;
+}
+
+void SmartOrderRouter::record_adaptive_run(const AdaptiveDecision& decision, OrderSide side, const std::vector<FillOrder>& fills,
+                                           std::chrono::nanoseconds runtime) const
+{
+    std::lock_guard<std::mutex> lock(m_adaptive_model->mutex);
+    const AdaptiveHybridConfig& config = m_adaptive_model->config;
+    AdaptiveModel::Bucket& bucket = m_adaptive_model->buckets[decision.bucket];
+    AdaptiveHybridStats& stats = m_adaptive_model->stats;
+
+    double runtime_us = std::chrono::duration<double, std::micro>(runtime).count();
+    Price benefit = decision.greedy_objective -
+        get_adaptive_objective(fills, decision.residual, side, decision.reference_price, config.shortfall_penalty_bps);
+    double notional = decision.residual * decision.reference_price;
+    double benefit_bps = (notional > 0.0) ? benefit / notional * 10000.0 : 0.0;
+
+    ++stats.optimizer_runs;
+    stats.runtime_us += runtime_us;
+    if (decision.exploring) 
+    {
+        ++stats.explorations;
+    }
+    else 
+    {
+        stats.predicted_benefit += decision.predicted_benefit;
+        stats.realized_benefit += benefit;
+        stats.predicted_runtime_us += decision.predicted_runtime_us;
+    }
+
+    double weight = (bucket.runs == 0) ? 1.0 : std::clamp(config.smoothing, 0.0, 1.0);
+    bucket.runtime_us += weight * (runtime_us - bucket.runtime_us);
+    bucket.benefit_bps += weight * (benefit_bps - bucket.benefit_bps);
+    ++bucket.runs;
+    bucket.declined_since_run = 0;
+}
+
+void SmartOrderRouter::set_adaptive_config(const AdaptiveHybridConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_adaptive_model->mutex);
+    m_adaptive_model->config = config;
+}
+
+AdaptiveHybridStats SmartOrderRouter::get_adaptive_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_adaptive_model->mutex);
+    AdaptiveHybridStats stats = m_adaptive_model->stats;
+    for (size_t i = 0; i < ADAPTIVE_BUCKETS; ++i) 
+    {
+        const AdaptiveModel::Bucket& bucket = m_adaptive_model->buckets[i];
+        if (bucket.runs == 0) continue;
+        stats.buckets.push_back({size_t(1) << i, bucket.runs, bucket.runtime_us, bucket.benefit_bps});
+    }
+    return stats;
+}
+
+void SmartOrderRouter::clear_adaptive_model()
+{
+    std::lock_guard<std::mutex> lock(m_adaptive_model->mutex);
+    std::fill(std::begin(m_adaptive_model->buckets), std::end(m_adaptive_model->buckets), AdaptiveModel::Bucket());
+    m_adaptive_model->stats = AdaptiveHybridStats();
+}
+
+OptimizerResult SmartOrderRouter::distribute_order_optimized(Volume remaining_size,
+                                                             OrderSide side,
+                                                             const std::vector<VenueCursor>& cursors,
+                                                             std::chrono::steady_clock::time_point deadline
+                                                            ) const 
+{
+    // Collect candidate lots for optimal solution, walking each book from its cursor in priority order
     // Go no deeper into each book than the remaining order size
     std::vector<FillOrder> available_lots;
-    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    std::vector<size_t> lot_venues;
+    const size_t venue_count = cursors.size();
+    for (size_t venue = 0; venue < venue_count; ++venue) 
     {
-        const auto& order_side = (side == OrderSide::BUY) ? order_book->get_asks() : order_book->get_bids();
-        Volume min_size = order_book->get_min_order_size();
+        const VenueCursor& cursor = cursors[venue];
+        if (cursor.exhausted) continue;
+
+        const ExchangeName exchange_name = cursor.book->get_exchange_name();
+        Volume min_size = cursor.book->get_min_order_size();
+        double fee = cursor.book->get_taker_fee();
         Volume cumulative_volume = 0.0;
 
-        for (const auto& [price, volume] : order_side) 
+        auto level = cursor.level;
+        Volume remaining_volume_at_level = cursor.level_volume;
+        while (cumulative_volume < remaining_size + EPSILON) 
         {
-            Volume remaining_volume_at_level = volume;
-            while (remaining_volume_at_level >= min_size && cumulative_volume < remaining_size + EPSILON) 
+            while (remaining_volume_at_level >= min_size - EPSILON && cumulative_volume < remaining_size + EPSILON) 
             {
-                available_lots.emplace_back(exchange_name, price, min_size);
+                available_lots.emplace_back(exchange_name, level->first, min_size, fee);
+                lot_venues.push_back(venue);
                 cumulative_volume += min_size;
                 remaining_volume_at_level -= min_size;
             }
+
+            if (side == OrderSide::BUY) 
+            {
+                if (++level == cursor.levels->end()) break;
+            } 
+            else 
+            {
+                if (level == cursor.levels->begin()) break;
+                --level;
+            }
+            remaining_volume_at_level = level->second;
         }
     }
 
-    // Sort by effective price
-    std::sort(available_lots.begin(), available_lots.end(),
-        [this, side](const FillOrder& a, const FillOrder& b) 
+    // Coarsening: each bucket of a venue's consecutive lots is costed at its worst lot and offered as
+    // items of 1, 2, 4, ... lots, which can form any lot count up to the bucket's size
+    const bool coarse = m_optimizer_coarsening.bucket_bps > 0.0 && available_lots.size() >= m_optimizer_coarsening.min_lots;
+    std::vector<FillOrder> real_lots;
+    std::vector<std::pair<size_t, size_t>> buckets;     // First real lot, lot count
+    std::vector<size_t> item_buckets;
+    std::vector<size_t> item_lot_counts;
+    Price max_bucket_spread = 0.0;
+    if (coarse) 
+    {
+        real_lots = std::move(available_lots);
+        std::vector<size_t> real_venues = std::move(lot_venues);
+        available_lots.clear();
+        lot_venues.clear();
+        for (size_t begin = 0; begin < real_lots.size();) 
         {
-            double fee_a = m_order_books->at(a.exchange_name)->get_taker_fee();
-            double fee_b = m_order_books->at(b.exchange_name)->get_taker_fee();
-            Price eff_a = (side == OrderSide::BUY) ? a.price * (1 + fee_a) : a.price * (1 - fee_a);
-            Price eff_b = (side == OrderSide::BUY) ? b.price * (1 + fee_b) : b.price * (1 - fee_b);
-            return (side == OrderSide::BUY) ? (eff_a < eff_b) : (eff_a > eff_b);
-        });
-
-    constexpr Price INVALID_BUY_COST = std::numeric_limits<Price>::max();
-    constexpr Price INVALID_SELL_COST = std::numeric_limits<Price>::min();
-    Price INVALID_COST = (side == OrderSide::BUY) ? INVALID_BUY_COST : INVALID_SELL_COST;
+            const FillOrder& best = real_lots[begin];
+            Price width = best.price * m_optimizer_coarsening.bucket_bps / 10000.0;
+            size_t end = begin + 1;
+            while (end < real_lots.size() && real_venues[end] == real_venues[begin] && std::abs(real_lots[end].price - best.price) <= width) 
+            {
+                ++end;
+            }
+            const FillOrder& worst = real_lots[end - 1];
+            max_bucket_spread = std::max(max_bucket_spread, std::abs(effective_price(worst.price, side, worst.fee_rate) -
+                                                                     effective_price(best.price, side, best.fee_rate)));
+            size_t bucket = buckets.size();
+            buckets.emplace_back(begin, end - begin);
+            for (size_t left = end - begin, count = 1; left > 0; count *= 2) 
+            {
+                size_t take = std::min(count, left);
+                available_lots.emplace_back(worst.exchange_name, worst.price, static_cast<double>(take) * worst.volume, worst.fee_rate);
+                lot_venues.push_back(real_venues[begin]);
+                item_buckets.push_back(bucket);
+                item_lot_counts.push_back(take);
+                left -= take;
+            }
+            begin = end;
+        }
+        SOR_LOG(LogLevel::DEBUG, "Optimizer coarsened {} lots into {} buckets, {} items", real_lots.size(), buckets.size(), available_lots.size());
+    }
 
-    // Memoization table
-    using MemoKey = std::pair<Volume, size_t>;
-    std::map<MemoKey, std::pair<Price, std::vector<FillOrder>>> memo;
+    // Signed unit cost: cost for BUY, negated proceeds for SELL, so the search always minimises
+    std::vector<size_t> order(available_lots.size());
+    std::vector<Price> unit_costs(available_lots.size());
+    for (size_t i = 0; i < available_lots.size(); ++i) 
+    {
+        Price eff = effective_price(available_lots[i].price, side, available_lots[i].fee_rate);
+        unit_costs[i] = (side == OrderSide::BUY) ? eff : -eff;
+        order[i] = i;
+    }
 
-    //Optimization solver
-    std::function<std::pair<Price, std::vector<FillOrder>>(Volume, size_t)> solve = 
-        [&](Volume remaining, size_t index) -> std::pair<Price, std::vector<FillOrder>> 
+    // Sort by effective price
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return unit_costs[a] < unit_costs[b]; });
+
+    const size_t lot_count = order.size();
+    std::vector<FillOrder> lots(lot_count);
+    std::vector<size_t> venues(lot_count);
+    std::vector<Price> costs(lot_count);
+    std::vector<Volume> prefix_volume(lot_count + 1, 0.0);
+    std::vector<Price> prefix_cost(lot_count + 1, 0.0);
+    std::vector<size_t> lot_buckets(coarse ? lot_count : 0);
+    std::vector<size_t> lot_counts(coarse ? lot_count : 0);
+    for (size_t i = 0; i < lot_count; ++i) 
+    {
+        lots[i] = available_lots[order[i]];
+        venues[i] = lot_venues[order[i]];
+        if (coarse) 
         {
-            MemoKey key = {remaining, index};
-            if (memo.count(key)) return memo[key];
-
-            // Base case: exact fill
-            if (remaining <= EPSILON) return {0.0, {}};
+            lot_buckets[i] = item_buckets[order[i]];
+            lot_counts[i] = item_lot_counts[order[i]];
+        }
+        costs[i] = lots[i].volume * unit_costs[order[i]];
+        prefix_volume[i + 1] = prefix_volume[i] + lots[i].volume;
+        prefix_cost[i + 1] = prefix_cost[i] + costs[i];
+    }
 
-            // Base case: no more lots
-            if (index >= available_lots.size()) 
+    // LP relaxation: cheapest cost of filling `needed` from lots [index, end) with the last lot split
+    auto fractional_bound = [&](size_t index, Volume needed) -> Price 
+    {
+        if (needed <= EPSILON) return 0.0;
+        Volume target = prefix_volume[index] + needed;
+        auto it = std::lower_bound(prefix_volume.begin() + index + 1, prefix_volume.end(), target - EPSILON);
+        if (it == prefix_volume.end()) return prefix_cost[lot_count] - prefix_cost[index];
+        size_t last = static_cast<size_t>(it - prefix_volume.begin()) - 1;
+        return prefix_cost[last] - prefix_cost[index] + (target - prefix_volume[last]) * (costs[last] / lots[last].volume);
+    };
+
+    // Larger fill wins; equal fills are ranked by cost
+    auto is_better = [](Volume volume_a, Price cost_a, Volume volume_b, Price cost_b) 
+    {
+        return volume_a > volume_b + EPSILON ||
+               (std::abs(volume_a - volume_b) <= EPSILON && cost_a < cost_b - EPSILON);
+    };
+
+    // Seed the incumbent with the greedy first-fit over sorted lots
+    std::vector<size_t> best_selection;
+    Volume best_volume = 0.0;
+    Price best_cost = 0.0;
+    for (size_t i = 0; i < lot_count; ++i) 
+    {
+        if (best_volume + lots[i].volume <= remaining_size + EPSILON) 
+        {
+            best_selection.push_back(i);
+            best_volume += lots[i].volume;
+            best_cost += costs[i];
+        }
+    }
+    SOR_LOG(LogLevel::DEBUG, "Optimizer seeded with greedy fill: Lots = {}, Volume = {}, Cost = {}", lot_count, best_volume, best_cost);
+
+    // Large residuals: each venue's lots share a size, so taking its k cheapest lots dominates any other
+    // k of them and the venue reduces to a cost curve. The curves are merged in parallel; the selection
+    // is summed in index order like the search below, and an incumbent that is not beaten is kept.
+    // Coarsened items of one venue differ in size, so neither the curves nor the closed-venue rule apply
+    bool solved_by_curves = false;
+    if (!coarse && lot_count >= m_parallel_optimizer_min_lots) 
+    {
+        std::vector<VenueCostCurve> curves;
+        std::vector<std::vector<size_t>> curve_lots;
+        std::vector<size_t> venue_curve(venue_count, SIZE_MAX);
+        for (size_t i = 0; i < lot_count; ++i) 
+        {
+            size_t& curve = venue_curve[venues[i]];
+            if (curve == SIZE_MAX) 
             {
-                return {INVALID_COST, {}};
+                curve = curves.size();
+                curves.push_back({lots[i].volume, {0.0}});
+                curve_lots.emplace_back();
             }
+            curves[curve].cumulative_cost.push_back(curves[curve].cumulative_cost.back() + costs[i]);
+            curve_lots[curve].push_back(i);
+        }
 
-            const FillOrder& lot = available_lots[index];
-            double fee = m_order_books->at(lot.exchange_name)->get_taker_fee();
-            Price lot_cost = lot.volume * lot.price * (1 + ((side == OrderSide::BUY) ? fee : -fee));
-
-            // Option 1: Take this lot (only if it doesn't overshoot)
-            auto take_solution = (lot.volume <= remaining + EPSILON)
-                ? solve(remaining - lot.volume, index + 1)
-                : std::make_pair(INVALID_COST, std::vector<FillOrder>{});
-            
-            if (take_solution.first != INVALID_COST) 
+        CostCurveSolution curve_solution;
+        if (solve_cost_curves(curves, remaining_size, &ThreadPool::shared(), deadline, curve_solution)) 
+        {
+            std::vector<size_t> selection;
+            for (size_t curve = 0; curve < curves.size(); ++curve) 
+            {
+                selection.insert(selection.end(), curve_lots[curve].begin(), curve_lots[curve].begin() + curve_solution.lots_per_venue[curve]);
+            }
+            std::sort(selection.begin(), selection.end());
+            Volume volume = 0.0;
+            Price cost = 0.0;
+            for (size_t index : selection) 
+            {
+                volume += lots[index].volume;
+                cost += costs[index];
+            }
+            if (is_better(volume, cost, best_volume, best_cost)) 
             {
-                take_solution.first += lot_cost;
-                take_solution.second.push_back(lot);
+                best_selection = std::move(selection);
+                best_volume = volume;
+                best_cost = cost;
             }
+            solved_by_curves = true;
+            SOR_LOG(LogLevel::DEBUG, "Optimizer merged {} venue cost curves: Volume = {}, Cost = {}", curves.size(), best_volume, best_cost);
+        }
+    }
 
-            // Option 2: Skip this lot
-            auto skip_solution = solve(remaining, index + 1);
+    // Lots of one venue share a size and are sorted, so skipping a lot closes its venue:
+    // any plan taking a later lot of that venue is matched or beaten by one taking the skipped lot
+    std::vector<size_t> current;
+    uint64_t closed_venues = 0;
+    bool track_closed = !coarse && venue_count <= 64;
+
+    // Dominance table: the same subproblem reached at a lower prefix cost makes this branch redundant
+    using StateKey = std::tuple<size_t, long long, uint64_t>;
+    std::map<StateKey, Price> visited;
 
-            // Select best valid solution
-            bool take_valid = (take_solution.first != INVALID_COST);
-            bool skip_valid = (skip_solution.first != INVALID_COST);
+    constexpr size_t DEADLINE_CHECK_MASK = 1023;
+    size_t nodes = 0;
+    bool timed_out = false;
 
-            if (take_valid && skip_valid) 
+    std::function<void(size_t, Volume, Price)> branch = 
+        [&](size_t index, Volume volume, Price cost) 
+        {
+            if (timed_out) return;
+            if ((nodes++ & DEADLINE_CHECK_MASK) == 0 && std::chrono::steady_clock::now() >= deadline) 
             {
-                memo[key] = (side == OrderSide::BUY)
-                    ? (take_solution.first < skip_solution.first ? take_solution : skip_solution)
-                    : (take_solution.first > skip_solution.first ? take_solution : skip_solution);
+                timed_out = true;
+                return;
             }
-            else if (take_valid) 
+
+            if (is_better(volume, cost, best_volume, best_cost)) 
             {
-                memo[key] = take_solution;
-            } 
-            else if (skip_valid) 
+                best_volume = volume;
+                best_cost = cost;
+                best_selection = current;
+            }
+
+            if (index >= lot_count || remaining_size - volume <= EPSILON) return;
+
+            // Bound: neither more volume nor a cheaper fill of the incumbent volume is reachable
+            Volume reachable = std::min(remaining_size, volume + prefix_volume[lot_count] - prefix_volume[index]);
+            if (reachable < best_volume - EPSILON) return;
+            if (reachable <= best_volume + EPSILON && cost + fractional_bound(index, best_volume - volume) >= best_cost - EPSILON) return;
+
+            StateKey key{index, std::llround((remaining_size - volume) / EPSILON), track_closed ? closed_venues : 0};
+            auto [state, inserted] = visited.try_emplace(key, cost);
+            if (!inserted) 
             {
-                memo[key] = skip_solution;
-            } 
-            else 
+                if (state->second <= cost) return;
+                state->second = cost;
+            }
+
+            const FillOrder& lot = lots[index];
+            uint64_t venue_bit = track_closed ? (uint64_t{1} << venues[index]) : 0;
+            bool venue_open = (closed_venues & venue_bit) == 0;
+
+            // Option 1: Take this lot (only if it doesn't overshoot)
+            if (venue_open && volume + lot.volume <= remaining_size + EPSILON) 
             {
-                memo[key] = {INVALID_COST, {}};
+                current.push_back(index);
+                branch(index + 1, volume + lot.volume, cost + costs[index]);
+                current.pop_back();
             }
 
-            return memo[key];
+            // Option 2: Skip this lot
+            uint64_t saved_closed = closed_venues;
+            closed_venues |= venue_bit;
+            branch(index + 1, volume, cost);
+            closed_venues = saved_closed;
         };
 
-    auto [total_cost, solution] = solve(remaining_size, 0);
-
-    // Fallback to the best undershoot if no exact solution
-    if (solution.empty() || total_cost == INVALID_COST) 
+    if (!solved_by_curves) 
     {
-        DEBUG_LOG("No exact solution found. Using best undershoot.");
-        Volume best_volume = 0.0;
-        Price best_cost = INVALID_COST;
-        solution.clear();
+        branch(0, 0.0, 0.0);
+    }
 
-        // Try all combinations to find the largest possible fill <= remaining_size
-        std::function<void(size_t, Volume, Price, std::vector<FillOrder>&)> backtrack =
-            [&](size_t start_idx, Volume current_volume, Price current_cost, std::vector<FillOrder>& current) 
-            {
-                if (current_volume > remaining_size + EPSILON) return;
+    OptimizerResult result;
+    result.proven_optimal = !timed_out;
+    result.optimality_gap = timed_out ? std::max(0.0, best_cost - fractional_bound(0, best_volume)) : 0.0;
+    // Fills rank by volume first, so an under-filled incumbent is mostly short on volume, not on cost
+    result.volume_gap = timed_out ? std::max(0.0, std::min(remaining_size, prefix_volume[lot_count]) - best_volume) : 0.0;
+    SOR_LOG(LogLevel::DEBUG, "Optimizer explored {} nodes, {}, Gap = {}, Volume Gap = {}", nodes,
+            timed_out ? "budget expired" : "search complete", result.optimality_gap, result.volume_gap);
 
-                // Update best solution
-                if (current_volume > best_volume + EPSILON ||
-                    (std::abs(current_volume - best_volume) <= EPSILON &&
-                    ((side == OrderSide::BUY && current_cost < best_cost) ||
-                    (side == OrderSide::SELL && current_cost > best_cost)))) 
-                {
-                    best_volume = current_volume;
-                    best_cost = current_cost;
-                    solution = current;
-                }
+    std::vector<FillOrder> solution;
+    for (size_t index : best_selection) 
+    {
+        solution.push_back(lots[index]);
+    }
 
-                for (size_t i = start_idx; i < available_lots.size(); ++i) 
-                {
-                    const FillOrder& lot = available_lots[i];
-                    double fee = m_order_books->at(lot.exchange_name)->get_taker_fee();
-                    Price cost = lot.volume * lot.price * (1 + ((side == OrderSide::BUY) ? fee : -fee));
-
-                    if (current_volume + lot.volume <= remaining_size + EPSILON) 
-                    {
-                        current.push_back(lot);
-                        backtrack(i + 1, current_volume + lot.volume, current_cost + cost, current);
-                        current.pop_back();
-                    }
-                }
-            };
+    // Refine: a bucket's chosen lot count is filled from its best real lots, which cost no more than
+    // the worst-price estimate. The error bound is the smaller of the widest bucket spread over the
+    // filled volume and the refined cost minus the LP bound of the real lots at that volume
+    if (coarse) 
+    {
+        std::vector<size_t> chosen(buckets.size(), 0);
+        for (size_t index : best_selection) 
+        {
+            chosen[lot_buckets[index]] += lot_counts[index];
+        }
+        solution.clear();
+        Volume volume = 0.0;
+        Price cost = 0.0;
+        for (size_t bucket = 0; bucket < buckets.size(); ++bucket) 
+        {
+            for (size_t j = 0; j < chosen[bucket]; ++j) 
+            {
+                const FillOrder& lot = real_lots[buckets[bucket].first + j];
+                solution.push_back(lot);
+                volume += lot.volume;
+                cost += (side == OrderSide::BUY ? 1.0 : -1.0) * lot.volume * effective_price(lot.price, side, lot.fee_rate);
+            }
+        }
 
-        std::vector<FillOrder> current;
-        backtrack(0, 0.0, 0.0, current);
-        total_cost = best_cost;
+        std::vector<std::pair<Price, Volume>> real_costs;
+        real_costs.reserve(real_lots.size());
+        for (const FillOrder& lot : real_lots) 
+        {
+            real_costs.emplace_back((side == OrderSide::BUY ? 1.0 : -1.0) * effective_price(lot.price, side, lot.fee_rate), lot.volume);
+        }
+        std::sort(real_costs.begin(), real_costs.end());
+        Price lp_bound = 0.0;
+        Volume needed = volume;
+        for (const auto& [unit_cost, lot_volume] : real_costs) 
+        {
+            if (needed <= EPSILON) break;
+            Volume take = std::min(needed, lot_volume);
+            lp_bound += take * unit_cost;
+            needed -= take;
+        }
+        result.coarsening_error_bound = std::max(0.0, std::min(volume * max_bucket_spread, cost - lp_bound));
+        SOR_LOG(LogLevel::DEBUG, "Optimizer refined {} buckets: Coarse cost = {}, Refined cost = {}, Error bound = {}",
+                buckets.size(), best_cost, cost, result.coarsening_error_bound);
+        best_cost = cost;
     }
-
     // Aggregate fills from same exchange and price level (for output)
-    std::map<std::pair<ExchangeName, Price>, Volume> aggregated;
+    std::map<std::pair<ExchangeName, Price>, FillOrder> aggregated;
     for (const auto& fill : solution) 
     {
-        auto key = std::make_pair(fill.exchange_name, fill.price);
-        aggregated[key] += fill.volume;
+        auto [it, inserted] = aggregated.try_emplace(std::make_pair(fill.exchange_name, fill.price), fill);
+        if (!inserted) it->second.volume += fill.volume;
     }
 
     solution.clear();
-    for (const auto& [key, volume] : aggregated) 
+    for (auto& [key, fill] : aggregated) 
     {
-        solution.emplace_back(key.first, key.second, volume);
+        solution.push_back(std::move(fill));
     }
 
     // Sort by effective price (for output)
     std::sort(solution.begin(), solution.end(),
-        [this, side](const FillOrder& a, const FillOrder& b) 
+        [side](const FillOrder& a, const FillOrder& b) 
         {
-            double fee_a = m_order_books->at(a.exchange_name)->get_taker_fee();
-            double fee_b = m_order_books->at(b.exchange_name)->get_taker_fee();
-            Price eff_a = (side == OrderSide::BUY) ? a.price * (1 + fee_a) : a.price * (1 - fee_a);
-            Price eff_b = (side == OrderSide::BUY) ? b.price * (1 + fee_b) : b.price * (1 - fee_b);
+            Price eff_a = effective_price(a.price, side, a.fee_rate);
+            Price eff_b = effective_price(b.price, side, b.fee_rate);
             return (side == OrderSide::BUY) ? (eff_a < eff_b) : (eff_a > eff_b);
         });
 
-    #ifdef DEBUG_MODE
-        // Print results
-        std::cout << "\n=== Optimal Solution ===\n";
+    if (EventLog::is_enabled(LogLevel::TRACE)) 
+    {
         Volume total_volume = 0.0;
         Price total_fees = 0.0;
-        for (const auto& fill : solution) {
-            double fee = m_order_books->at(fill.exchange_name)->get_taker_fee();
-            Price eff_price = (side == OrderSide::BUY) ? fill.price * (1 + fee) : fill.price * (1 - fee);
-            Price fill_cost = fill.volume * fill.price;
-            Price fill_fee = fill_cost * fee;
-
-            std::cout << "Exchange: " << std::setw(8) << fill.exchange_name
-                    << " | Price: " << std::setw(10) << fill.price
-                    << " | Volume: " << std::setw(8) << fill.volume
-                    << " | Eff. Price: " << std::setw(12) << eff_price
-                    << " | Fees: " << std::setw(8) << fill_fee << "\n";
-
+        for (const auto& fill : solution) 
+        {
+            Price fill_fee = fill.volume * fill.price * fill.fee_rate;
+            SOR_LOG(LogLevel::TRACE, "Optimal solution fill: Exchange = {}, Price = {}, Volume = {}, Eff. Price = {}, Fees = {}",
+                    fill.exchange_name, fill.price, fill.volume, effective_price(fill.price, side, fill.fee_rate), fill_fee);
             total_volume += fill.volume;
             total_fees += fill_fee;
         }
+        Price total_cost = (side == OrderSide::BUY) ? best_cost : -best_cost;
+        SOR_LOG(LogLevel::TRACE, "Optimal solution: Total Volume = {}, Total Cost = {}, Total Fees = {}, Effective Price = {}",
+                total_volume, total_cost, total_fees, total_cost / std::max(total_volume, EPSILON));
+    }
 
-        std::cout << "\nSummary:\n";
-        std::cout << "Total Volume: " << total_volume << "\n";
-        std::cout << "Total Cost: " << total_cost << "\n";
-        std::cout << "Total Fees: " << total_fees << "\n";
-        std::cout << "Effective Price: " << total_cost / std::max(total_volume, EPSILON) << "\n";
-        std::cout << "====================================\n";
-    #endif
+    result.fills = std::move(solution);
+    return result;
+}
+
+std::vector<LiquiditySnapshot> SmartOrderRouter::get_liquidity_snapshots() const
+{
+    std::vector<LiquiditySnapshot> snapshots;
+    snapshots.reserve(m_order_books->size());
+    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    {
+        snapshots.push_back(order_book->get_liquidity_snapshot());
+    }
+    std::sort(snapshots.begin(), snapshots.end(),
+              [](const LiquiditySnapshot& a, const LiquiditySnapshot& b) { return a.exchange_name < b.exchange_name; });
+    return snapshots;
+}
 
-    return solution;
+std::vector<VenueLiquidity> SmartOrderRouter::get_liquidity(OrderSide side) const
+{
+    std::vector<VenueLiquidity> liquidity;
+    liquidity.reserve(m_order_books->size());
+    for (const LiquiditySnapshot& snapshot : get_liquidity_snapshots()) 
+    {
+        const SideLiquidity& levels = (side == OrderSide::BUY) ? snapshot.asks : snapshot.bids;
+        liquidity.push_back({snapshot.exchange_name, levels.best_price, levels.volume, levels.levels});
+    }
+    return liquidity;
 }
 
-void SmartOrderRouter::print_remaining_liquidity() const
+void SmartOrderRouter::print_remaining_liquidity(std::ostream& output) const
 {
-    std::cout << "\n=== Remaining Liquidity Across Exchanges ===" << std::endl;
+    std::vector<LiquiditySnapshot> snapshots = get_liquidity_snapshots();
+    output << "\n=== Remaining Liquidity Across Exchanges ===" << std::endl;
     
     double total_buy_liquidity = 0.0;
     double total_sell_liquidity = 0.0;
     size_t total_buy_levels = 0;
     size_t total_sell_levels = 0;
 
-    // Calculate and print buy-side (bids) liquidity
-    std::cout << "\nBuy-Side (Bids) Liquidity:" << std::endl;
-    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    // Buy-side (bids) liquidity
+    output << "\nBuy-Side (Bids) Liquidity:" << std::endl;
+    for (const LiquiditySnapshot& snapshot : snapshots) 
     {
-        double exchange_bid_volume = 0.0;
-        const auto& bids = order_book->get_bids();
-        for (const auto& [price, volume] : bids) 
-        {
-            exchange_bid_volume += volume;
-        }
-        total_buy_liquidity += exchange_bid_volume;
-        total_buy_levels += bids.size();
-        
-        std::cout << std::left << std::setw(10) << exchange_name 
-                  << ": " << std::fixed << std::setprecision(5) << exchange_bid_volume
-                  << " units across " << bids.size() << " price levels" << std::endl;
+        total_buy_liquidity += snapshot.bids.volume;
+        total_buy_levels += snapshot.bids.levels;
+        output << std::left << std::setw(10) << snapshot.exchange_name 
+               << ": " << std::fixed << std::setprecision(5) << snapshot.bids.volume
+               << " units across " << snapshot.bids.levels << " price levels" << std::endl;
     }
 
-    // Calculate and print sell-side (asks) liquidity
-    std::cout << "\nSell-Side (Asks) Liquidity:" << std::endl;
-    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    // Sell-side (asks) liquidity
+    output << "\nSell-Side (Asks) Liquidity:" << std::endl;
+    for (const LiquiditySnapshot& snapshot : snapshots) 
     {
-        double exchange_ask_volume = 0.0;
-        const auto& asks = order_book->get_asks();
-        for (const auto& [price, volume] : asks) 
-        {
-            exchange_ask_volume += volume;
-        }
-        total_sell_liquidity += exchange_ask_volume;
-        total_sell_levels += asks.size();
-        
-        std::cout << std::left << std::setw(10) << exchange_name 
-                  << ": " << std::fixed << std::setprecision(8) << exchange_ask_volume
-                  << " units across " << asks.size() << " price levels" << std::endl;
+        total_sell_liquidity += snapshot.asks.volume;
+        total_sell_levels += snapshot.asks.levels;
+        output << std::left << std::setw(10) << snapshot.exchange_name 
+               << ": " << std::fixed << std::setprecision(8) << snapshot.asks.volume
+               << " units across " << snapshot.asks.levels << " price levels" << std::endl;
     }
 
     // Print totals
-    std::cout << "\nTotal Liquidity:" << std::endl;
-    std::cout << "Buy-Side : " << std::fixed << std::setprecision(8) << total_buy_liquidity
-              << " units across " << total_buy_levels << " price levels" << std::endl;
-    std::cout << "Sell-Side: " << std::fixed << std::setprecision(8) << total_sell_liquidity
-              << " units across " << total_sell_levels << " price levels" << std::endl;
+    output << "\nTotal Liquidity:" << std::endl;
+    output << "Buy-Side : " << std::fixed << std::setprecision(8) << total_buy_liquidity
+           << " units across " << total_buy_levels << " price levels" << std::endl;
+    output << "Sell-Side: " << std::fixed << std::setprecision(8) << total_sell_liquidity
+           << " units across " << total_sell_levels << " price levels" << std::endl;
 
     // Print best bids and asks
-    std::cout << "\nBest Available Prices:" << std::endl;
-    for (const auto& [exchange_name, order_book] : *m_order_books) 
+    output << "\nBest Available Prices:" << std::endl;
+    for (const LiquiditySnapshot& snapshot : snapshots) 
     {
-        auto best_bid = order_book->get_best_bid();
-        auto best_ask = order_book->get_best_ask();
-        
-        std::cout << std::left << std::setw(10) << exchange_name 
-                  << ": Best Bid = " << std::setw(10) << best_bid.first 
-                  << " (" << best_bid.second << " units)"
-                  << " | Best Ask = " << std::setw(10) << best_ask.first 
-                  << " (" << best_ask.second << " units)"
-                  << std::endl;
-    }
-    std::cout << "=======================================\n" << std::endl;
+        output << std::left << std::setw(10) << snapshot.exchange_name 
+               << ": Best Bid = " << std::setw(10) << snapshot.bids.best_price 
+               << " (" << snapshot.bids.best_volume << " units)"
+               << " | Best Ask = " << std::setw(10) << snapshot.asks.best_price 
+               << " (" << snapshot.asks.best_volume << " units)"
+               << std::endl;
+    }
+    output << "=======================================\n" << std::endl;
 }
\ No newline at end of file
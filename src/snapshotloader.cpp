@@ -0,0 +1,123 @@
+#include "snapshotloader.h"
+#include "utils.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<ManifestEntry> read_manifest(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) 
+    {
+        throw std::runtime_error("Could not open manifest " + path);
+    }
+
+    std::filesystem::path base = std::filesystem::path(path).parent_path();
+    std::vector<ManifestEntry> manifest;
+    std::string line;
+    std::getline(file, line); // Skip the header row
+    for (size_t row = 2; std::getline(file, line); ++row) 
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::stringstream ss(line);
+        std::string symbol, exchange_name, fee, min_size, snapshot;
+        std::getline(ss, symbol, ',');
+        std::getline(ss, exchange_name, ',');
+        std::getline(ss, fee, ',');
+        std::getline(ss, min_size, ',');
+        std::getline(ss, snapshot, ',');
+        if (symbol.empty() || exchange_name.empty() || snapshot.empty()) 
+        {
+            throw std::runtime_error("Malformed manifest row " + std::to_string(row) + " in " + path);
+        }
+
+        ManifestEntry entry;
+        entry.symbol = symbol;
+        bool valid = false;
+        try 
+        {
+            entry.venue = {exchange_name, std::stod(fee), std::stod(min_size)};
+            // Routing steps through lots of the min order size, so it has to be a finite positive amount
+            valid = entry.venue.taker_fee >= 0.0 && std::isfinite(entry.venue.taker_fee) &&
+                    entry.venue.min_order_size > 0.0 && std::isfinite(entry.venue.min_order_size);
+        } 
+        catch (const std::exception&) 
+        {
+        }
+        if (!valid) 
+        {
+            throw std::runtime_error("Malformed fee or min order size on manifest row " + std::to_string(row) + " in " + path);
+        }
+        std::filesystem::path snapshot_path(snapshot);
+        entry.file = snapshot_path.is_absolute() ? snapshot : (base / snapshot_path).string();
+        manifest.push_back(std::move(entry));
+    }
+    return manifest;
+}
+
+LoadReport load_snapshots(SymbolRegistry& registry, const std::vector<ManifestEntry>& manifest, ThreadPool& pool)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // The registry is not thread-safe, so books are created up front and only filled in parallel
+    std::vector<std::shared_ptr<OrderBook>> books;
+    books.reserve(manifest.size());
+    for (const ManifestEntry& entry : manifest) 
+    {
+        books.push_back(registry.add_venue(registry.register_symbol(entry.symbol), entry.venue));
+    }
+
+    LoadReport report;
+    report.files.resize(manifest.size());
+    pool.parallel_for(manifest.size(), [&](size_t index) 
+    {
+        const ManifestEntry& entry = manifest[index];
+        FileLoadTiming& timing = report.files[index];
+        timing.symbol = entry.symbol;
+        timing.exchange_name = entry.venue.exchange_name;
+        timing.file = entry.file;
+
+        auto file_start = std::chrono::steady_clock::now();
+        try 
+        {
+            if (!std::filesystem::is_regular_file(entry.file)) 
+            {
+                timing.error = "file not found";
+            } 
+            else 
+            {
+                timing.rows = read_csv(entry.file, *books[index]);
+            }
+        } 
+        catch (const std::exception& e) 
+        {
+            timing.error = e.what();
+        }
+        timing.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - file_start);
+    });
+
+    for (const FileLoadTiming& timing : report.files) 
+    {
+        if (!timing.error.empty()) ++report.failed;
+    }
+    report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return report;
+}
+
+void print_load_report(const LoadReport& report, std::ostream& output)
+{
+    for (const FileLoadTiming& timing : report.files) 
+    {
+        output << std::left << std::setw(12) << timing.symbol << std::setw(10) << timing.exchange_name << std::right
+               << std::setw(8) << timing.rows << " rows " << std::setw(10) << timing.elapsed.count() << " us  " << timing.file;
+        if (!timing.error.empty()) output << "  (" << timing.error << ")";
+        output << "\n";
+    }
+    output << "Loaded " << report.files.size() - report.failed << "/" << report.files.size() << " snapshots in "
+           << report.elapsed.count() << " us" << std::endl;
+}
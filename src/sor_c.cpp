@@ -0,0 +1,212 @@
+#include "sor_c.h"
+#include "smartorderrouter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct sor_router
+{
+    std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>> books;
+    // Built on first use and dropped whenever a venue is added
+    std::unique_ptr<SmartOrderRouter> router;
+    std::mutex router_mutex;
+
+    SmartOrderRouter& get_router()
+    {
+        std::lock_guard<std::mutex> lock(router_mutex);
+        if (!router) router = std::make_unique<SmartOrderRouter>(books);
+        return *router;
+    }
+};
+
+namespace
+{
+bool valid_name(const char* exchange_name)
+{
+    return exchange_name && exchange_name[0] != '\0' && std::strlen(exchange_name) < SOR_EXCHANGE_NAME_SIZE;
+}
+
+void copy_name(char (&destination)[SOR_EXCHANGE_NAME_SIZE], const ExchangeName& name)
+{
+    size_t length = std::min<size_t>(name.size(), SOR_EXCHANGE_NAME_SIZE - 1);
+    std::memcpy(destination, name.data(), length);
+    destination[length] = '\0';
+}
+
+std::chrono::microseconds to_budget(int64_t latency_budget_us)
+{
+    return latency_budget_us < 0 ? NO_LATENCY_BUDGET : std::chrono::microseconds(latency_budget_us);
+}
+
+sor_status write_plan(const ExecutionPlan& plan, sor_fill* fills, size_t fill_capacity, sor_plan_summary* summary)
+{
+    const std::vector<FillOrder>& plan_fills = plan.get_plan();
+    summary->fill_count = plan_fills.size();
+    if (plan_fills.size() > fill_capacity) return SOR_BUFFER_TOO_SMALL;
+
+    summary->filled_volume = 0.0;
+    for (size_t i = 0; i < plan_fills.size(); ++i) 
+    {
+        copy_name(fills[i].exchange_name, plan_fills[i].exchange_name);
+        fills[i].price = plan_fills[i].price;
+        fills[i].volume = plan_fills[i].volume;
+        summary->filled_volume += plan_fills[i].volume;
+    }
+    summary->total = plan.get_total();
+    summary->fees = plan.get_total_fees();
+    summary->average_price = plan.get_average_effective_price();
+    summary->optimizer_used = plan.is_optimizer_used() ? 1 : 0;
+    summary->proven_optimal = plan.is_proven_optimal() ? 1 : 0;
+    return SOR_OK;
+}
+
+bool valid_order(sor_router* router, double size, sor_side side, sor_algorithm algorithm,
+                 sor_fill* fills, size_t fill_capacity, sor_plan_summary* summary)
+{
+    return router && summary && size > 0.0 && std::isfinite(size) && (fills || fill_capacity == 0) &&
+           (side == SOR_BUY || side == SOR_SELL) && (algorithm == SOR_PURE_GREEDY || algorithm == SOR_HYBRID || algorithm == SOR_ADAPTIVE);
+}
+
+OrderSide to_side(sor_side side)
+{
+    return side == SOR_BUY ? OrderSide::BUY : OrderSide::SELL;
+}
+
+RoutingAlgorithm to_algorithm(sor_algorithm algorithm)
+{
+    if (algorithm == SOR_ADAPTIVE) return RoutingAlgorithm::ADAPTIVE;
+    return algorithm == SOR_HYBRID ? RoutingAlgorithm::HYBRID : RoutingAlgorithm::PURE_GREEDY;
+}
+}
+
+sor_router* sor_router_create(void)
+{
+    return new (std::nothrow) sor_router();
+}
+
+void sor_router_destroy(sor_router* router)
+{
+    delete router;
+}
+
+sor_status sor_add_venue(sor_router* router, const char* exchange_name, double taker_fee, double min_order_size)
+{
+    // Routing steps through lots of min_order_size, so a zero or non-finite size would never advance
+    if (!router || !valid_name(exchange_name) || !(taker_fee >= 0.0) || !std::isfinite(taker_fee) ||
+        !(min_order_size > 0.0) || !std::isfinite(min_order_size)) 
+    {
+        return SOR_INVALID_ARGUMENT;
+    }
+    try 
+    {
+        auto [it, inserted] = router->books.try_emplace(exchange_name, nullptr);
+        if (!inserted) return SOR_DUPLICATE_VENUE;
+        it->second = std::make_shared<OrderBook>(exchange_name, taker_fee, min_order_size);
+        router->router.reset();
+        return SOR_OK;
+    } 
+    catch (...) 
+    {
+        return SOR_INTERNAL_ERROR;
+    }
+}
+
+sor_status sor_set_level(sor_router* router, const char* exchange_name, sor_book_side side, double price, double volume)
+{
+    if (!router || !valid_name(exchange_name) || !(price > 0.0) || (side != SOR_BID && side != SOR_ASK)) 
+    {
+        return SOR_INVALID_ARGUMENT;
+    }
+    try 
+    {
+        auto it = router->books.find(exchange_name);
+        if (it == router->books.end()) return SOR_UNKNOWN_VENUE;
+        if (side == SOR_BID) it->second->set_bid_volume(price, volume);
+        else it->second->set_ask_volume(price, volume);
+        return SOR_OK;
+    } 
+    catch (...) 
+    {
+        return SOR_INTERNAL_ERROR;
+    }
+}
+
+sor_status sor_distribute_order(sor_router* router, double size, sor_side side, sor_algorithm algorithm,
+                                int64_t latency_budget_us, sor_fill* fills, size_t fill_capacity,
+                                sor_plan_summary* summary)
+{
+    if (!valid_order(router, size, side, algorithm, fills, fill_capacity, summary)) return SOR_INVALID_ARGUMENT;
+    try 
+    {
+        LiquidityReservation reservation = router->get_router().reserve_order(size, to_side(side), to_algorithm(algorithm),
+                                                                              to_budget(latency_budget_us));
+        // Check the buffer before committing so a too-small buffer leaves the books untouched
+        summary->fill_count = reservation.get_plan().get_plan().size();
+        if (summary->fill_count > fill_capacity) return SOR_BUFFER_TOO_SMALL;   // Reservation releases on destruction
+        return write_plan(reservation.commit(), fills, fill_capacity, summary);
+    } 
+    catch (...) 
+    {
+        return SOR_INTERNAL_ERROR;
+    }
+}
+
+sor_status sor_quote(sor_router* router, double size, sor_side side, sor_algorithm algorithm,
+                     int64_t latency_budget_us, sor_fill* fills, size_t fill_capacity,
+                     sor_plan_summary* summary)
+{
+    if (!valid_order(router, size, side, algorithm, fills, fill_capacity, summary)) return SOR_INVALID_ARGUMENT;
+    try 
+    {
+        ExecutionPlan plan = router->get_router().quote(size, to_side(side), to_algorithm(algorithm), to_budget(latency_budget_us));
+        return write_plan(plan, fills, fill_capacity, summary);
+    } 
+    catch (...) 
+    {
+        return SOR_INTERNAL_ERROR;
+    }
+}
+
+sor_status sor_get_liquidity(sor_router* router, sor_side side, sor_venue_liquidity* venues,
+                             size_t venue_capacity, size_t* venue_count)
+{
+    if (!router || !venue_count || (!venues && venue_capacity != 0) || (side != SOR_BUY && side != SOR_SELL)) 
+    {
+        return SOR_INVALID_ARGUMENT;
+    }
+    try 
+    {
+        std::vector<VenueLiquidity> liquidity = router->get_router().get_liquidity(to_side(side));
+        *venue_count = liquidity.size();
+        if (liquidity.size() > venue_capacity) return SOR_BUFFER_TOO_SMALL;
+        for (size_t i = 0; i < liquidity.size(); ++i) 
+        {
+            copy_name(venues[i].exchange_name, liquidity[i].exchange_name);
+            venues[i].best_price = liquidity[i].best_price;
+            venues[i].volume = liquidity[i].volume;
+            venues[i].levels = liquidity[i].levels;
+        }
+        return SOR_OK;
+    } 
+    catch (...) 
+    {
+        return SOR_INTERNAL_ERROR;
+    }
+}
+
+const char* sor_status_string(sor_status status)
+{
+    switch (status) 
+    {
+        case SOR_OK: return "ok";
+        case SOR_INVALID_ARGUMENT: return "invalid argument";
+        case SOR_UNKNOWN_VENUE: return "unknown venue";
+        case SOR_DUPLICATE_VENUE: return "duplicate venue";
+        case SOR_BUFFER_TOO_SMALL: return "buffer too small";
+        case SOR_INTERNAL_ERROR: return "internal error";
+    }
+    return "unknown status";
+}
@@ -0,0 +1,110 @@
+#include "symbolregistry.h"
+#include <stdexcept>
+
+SymbolId SymbolRegistry::register_symbol(const std::string& symbol)
+{
+    auto it = m_symbol_ids.find(symbol);
+    if (it != m_symbol_ids.end()) 
+    {
+        return it->second;
+    }
+
+    SymbolId id = static_cast<SymbolId>(m_symbols.size());
+    m_symbols.push_back({symbol, {}, nullptr});
+    m_symbol_ids.emplace(symbol, id);
+    return id;
+}
+
+std::shared_ptr<OrderBook> SymbolRegistry::add_venue(SymbolId id, const VenueConfig& config)
+{
+    SymbolEntry& entry = get_entry(id);
+    for (const auto& book : entry.books) 
+    {
+        if (book->get_exchange_name() == config.exchange_name) 
+        {
+            throw std::runtime_error("Venue " + config.exchange_name + " already registered for " + entry.symbol);
+        }
+    }
+
+    auto book = std::make_shared<OrderBook>(config.exchange_name, config.taker_fee, config.min_order_size);
+    book->set_depth_limits(config.depth_limits);
+    entry.books.push_back(book);
+    entry.router.reset();   // The router snapshots its venue set, rebuild it on next use
+    return book;
+}
+
+SymbolId SymbolRegistry::get_symbol_id(const std::string& symbol) const
+{
+    auto it = m_symbol_ids.find(symbol);
+    if (it == m_symbol_ids.end()) 
+    {
+        throw std::out_of_range("Unknown symbol: " + symbol);
+    }
+    return it->second;
+}
+
+const std::string& SymbolRegistry::get_symbol(SymbolId id) const
+{
+    return get_entry(id).symbol;
+}
+
+std::shared_ptr<OrderBook> SymbolRegistry::get_book(SymbolId id, const ExchangeName& exchange_name) const
+{
+    for (const auto& book : get_entry(id).books) 
+    {
+        if (book->get_exchange_name() == exchange_name) 
+        {
+            return book;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<std::shared_ptr<OrderBook>>& SymbolRegistry::get_books(SymbolId id) const
+{
+    return get_entry(id).books;
+}
+
+size_t SymbolRegistry::size() const
+{
+    return m_symbols.size();
+}
+
+SmartOrderRouter& SymbolRegistry::get_router(SymbolId id)
+{
+    SymbolEntry& entry = get_entry(id);
+    if (!entry.router) 
+    {
+        std::unordered_map<ExchangeName, std::shared_ptr<OrderBook>> order_books;
+        for (const auto& book : entry.books) 
+        {
+            order_books.emplace(book->get_exchange_name(), book);
+        }
+        entry.router = std::make_unique<SmartOrderRouter>(std::move(order_books));
+    }
+    return *entry.router;
+}
+
+ExecutionPlan SymbolRegistry::distribute_order(SymbolId id, Volume order_size, OrderSide side,
+                                               RoutingAlgorithm algorithm, std::chrono::microseconds latency_budget)
+{
+    return get_router(id).distribute_order(order_size, side, algorithm, latency_budget);
+}
+
+SymbolRegistry::SymbolEntry& SymbolRegistry::get_entry(SymbolId id)
+{
+    if (id >= m_symbols.size()) 
+    {
+        throw std::out_of_range("Unknown symbol id: " + std::to_string(id));
+    }
+    return m_symbols[id];
+}
+
+const SymbolRegistry::SymbolEntry& SymbolRegistry::get_entry(SymbolId id) const
+{
+    if (id >= m_symbols.size()) 
+    {
+        throw std::out_of_range("Unknown symbol id: " + std::to_string(id));
+    }
+    return m_symbols[id];
+}
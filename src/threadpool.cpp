@@ -0,0 +1,106 @@
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t worker_count)
+{
+    m_workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) 
+    {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_task_ready.notify_all();
+    for (std::thread& worker : m_workers) 
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+size_t ThreadPool::get_worker_count() const
+{
+    return m_workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_task_ready.notify_one();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true) 
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task_ready.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0) return;
+
+    // Helpers that start after the caller has claimed every index exit without touching `task`,
+    // so the shared state has to outlive this call but the task does not
+    struct Job
+    {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> completed{0};
+        size_t count;
+        const std::function<void(size_t)>* task;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto job = std::make_shared<Job>();
+    job->count = count;
+    job->task = &task;
+
+    auto run = [](Job& state) 
+    {
+        size_t index;
+        while ((index = state.next.fetch_add(1, std::memory_order_relaxed)) < state.count) 
+        {
+            (*state.task)(index);
+            if (state.completed.fetch_add(1, std::memory_order_acq_rel) + 1 == state.count) 
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(m_workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) 
+    {
+        submit([job, run]() { run(*job); });
+    }
+    run(*job);
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&job]() { return job->completed.load(std::memory_order_acquire) == job->count; });
+}
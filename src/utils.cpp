@@ -3,16 +3,17 @@
 #include <sstream>
 #include <stdexcept>
 
-void read_csv(const std::string& filename, OrderBook& order_book) 
+size_t read_csv(const std::string& filename, OrderBook& order_book) 
 {
     std::ifstream file(filename);
 
     if (!file.is_open()) 
     {
         std::cerr << "Error: Could not open file " << filename << std::endl;
-        return;
+        return 0;
     }
 
+    size_t rows = 0;
     std::string line;
     std::getline(file, line); // Skip the header row
 
@@ -31,12 +32,15 @@ void read_csv(const std::string& filename, OrderBook& order_book)
         if (type == "Bid") 
         {
             order_book.add_bid(price, volume);
+            ++rows;
         }
         else if (type == "Ask")
         {
             order_book.add_ask(price, volume);
+            ++rows;
         }
     }
 
     file.close();
+    return rows;
 }
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "venuesimulator.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// Timed waits overshoot by tens of microseconds, so the last stretch before an event is spun
+constexpr std::chrono::microseconds SPIN_WINDOW{50};
+constexpr Volume DUST = 1e-9;
+}
+
+VenueSimulator::VenueSimulator(const OrderBook& book, VenueBehaviour behaviour, unsigned seed)
+    : m_book(book.get_exchange_name(), book.get_taker_fee(), book.get_min_order_size()),
+      m_behaviour(behaviour), m_rng(seed), m_worker_rng(seed + 1)
+{
+    {
+        auto lock = book.read_lock();
+        for (const auto& [price, level] : book.get_bids())
+        {
+            if (level.load() > 0.0) m_book.add_bid(price, level.load());
+        }
+        for (const auto& [price, level] : book.get_asks())
+        {
+            if (level.load() > 0.0) m_book.add_ask(price, level.load());
+        }
+    }
+    m_worker = std::thread(&VenueSimulator::run, this);
+}
+
+VenueSimulator::~VenueSimulator()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_event_ready.notify_all();
+    m_worker.join();
+}
+
+std::chrono::nanoseconds VenueSimulator::sample_latency(std::mt19937& rng) const
+{
+    std::chrono::nanoseconds latency = m_behaviour.latency;
+    if (m_behaviour.jitter.count() > 0)
+    {
+        std::exponential_distribution<double> jitter(1.0 / static_cast<double>(m_behaviour.jitter.count()));
+        latency += std::chrono::nanoseconds(static_cast<int64_t>(jitter(rng) * 1000.0));
+    }
+    return latency;
+}
+
+void VenueSimulator::schedule(std::chrono::steady_clock::time_point due, std::function<void()> action)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push(Event{due, m_sequence++, std::move(action)});
+    }
+    m_event_ready.notify_one();
+}
+
+void VenueSimulator::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        if (m_events.empty())
+        {
+            m_event_ready.wait(lock);
+            continue;
+        }
+
+        auto due = m_events.top().due;
+        auto now = std::chrono::steady_clock::now();
+        if (now < due)
+        {
+            if (due - now > SPIN_WINDOW)
+            {
+                m_event_ready.wait_until(lock, due - SPIN_WINDOW);
+            }
+            else
+            {
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+            continue;
+        }
+
+        Event event = m_events.top();
+        m_events.pop();
+        lock.unlock();
+        event.action();
+        lock.lock();
+    }
+}
+
+ExecutionReport VenueSimulator::match(const ChildOrder& order)
+{
+    const bool buy = (order.side == OrderSide::BUY);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // Other participants may have lifted the top of the book while the order was on the wire
+    if (unit(m_worker_rng) < m_behaviour.competition_probability)
+    {
+        if (buy && m_book.get_best_ask().second > 0.0) m_book.remove_top_ask();
+        if (!buy && m_book.get_best_bid().second > 0.0) m_book.remove_top_bid();
+    }
+
+    Volume target = order.volume;
+    if (unit(m_worker_rng) < m_behaviour.partial_fill_probability)
+    {
+        std::uniform_real_distribution<double> ratio(std::clamp(m_behaviour.min_fill_ratio, 0.0, 1.0), 1.0);
+        target *= ratio(m_worker_rng);
+    }
+
+    ExecutionReport report{order.id, m_book.get_exchange_name(), order.volume, 0.0, 0.0, m_book.get_taker_fee(), {}, {}, {}};
+    Price notional = 0.0;
+    while (report.filled < target - DUST)
+    {
+        auto [price, volume] = buy ? m_book.get_best_ask() : m_book.get_best_bid();
+        if (volume <= 0.0 || (buy ? price > order.limit_price : price < order.limit_price)) break;
+
+        Volume take = std::min(volume, target - report.filled);
+        Volume left = (volume - take <= DUST) ? 0.0 : volume - take;
+        if (buy)
+        {
+            m_book.set_ask_volume(price, left);
+        }
+        else
+        {
+            m_book.set_bid_volume(price, left);
+        }
+        report.filled += take;
+        notional += take * price;
+    }
+    report.average_price = (report.filled > 0.0) ? notional / report.filled : 0.0;
+    return report;
+}
+
+void VenueSimulator::submit(const ChildOrder& order, std::function<void(const ExecutionReport&)> on_report)
+{
+    auto sent = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds outbound;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        outbound = sample_latency(m_rng);
+    }
+
+    schedule(sent + outbound, [this, order, sent, on_report = std::move(on_report)]()
+    {
+        ExecutionReport report = match(order);
+        report.sent = sent;
+        report.matched = std::chrono::steady_clock::now();
+        schedule(report.matched + sample_latency(m_worker_rng), [report, on_report]() mutable
+        {
+            report.received = std::chrono::steady_clock::now();
+            on_report(report);
+        });
+    });
+}
+
+const ExchangeName VenueSimulator::get_exchange_name() const
+{
+    return m_book.get_exchange_name();
+}
+
+const OrderBook& VenueSimulator::get_book() const
+{
+    return m_book;
+}
+
+LatencySummary summarize_latencies(std::vector<std::chrono::nanoseconds> samples)
+{
+    LatencySummary summary;
+    if (samples.empty()) return summary;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double fraction)
+    {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(fraction * static_cast<double>(samples.size())))];
+    };
+    summary.p50 = at(0.5);
+    summary.p90 = at(0.9);
+    summary.p99 = at(0.99);
+    summary.max = samples.back();
+    return summary;
+}
+
+SimulationDriver::SimulationDriver(SmartOrderRouter& router, const std::vector<std::unique_ptr<VenueSimulator>>& venues)
+    : m_router(router)
+{
+    for (const auto& venue : venues)
+    {
+        m_venues[venue->get_exchange_name()] = venue.get();
+    }
+}
+
+void SimulationDriver::set_limit_tolerance(double bps)
+{
+    m_limit_tolerance_bps = std::max(0.0, bps);
+}
+
+RoundTrip SimulationDriver::execute(Volume order_size, OrderSide side, RoutingAlgorithm algorithm,
+                                    std::chrono::steady_clock::time_point tick)
+{
+    RoundTrip trip{m_router.distribute_order(order_size, side, algorithm), {}};
+    trip.route_latency = std::chrono::steady_clock::now() - tick;
+
+    const std::vector<FillOrder>& fills = trip.plan.get_plan();
+    trip.reports.resize(fills.size());
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending = fills.size();
+
+    // Checked up front: once a child is out, its report refers to this frame
+    std::vector<VenueSimulator*> targets;
+    targets.reserve(fills.size());
+    for (const FillOrder& fill : fills)
+    {
+        auto venue = m_venues.find(fill.exchange_name);
+        if (venue == m_venues.end())
+        {
+            throw std::runtime_error("No venue simulator for " + fill.exchange_name);
+        }
+        targets.push_back(venue->second);
+    }
+
+    const double tolerance = m_limit_tolerance_bps / 10000.0;
+    for (size_t i = 0; i < fills.size(); ++i)
+    {
+        Price limit = (side == OrderSide::BUY) ? fills[i].price * (1 + tolerance) : fills[i].price * (1 - tolerance);
+        targets[i]->submit(ChildOrder{m_next_child_id++, side, limit, fills[i].volume},
+            [&, i](const ExecutionReport& report)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                trip.reports[i] = report;
+                if (--pending == 0) done.notify_one();     // Under the lock: the waiter owns `done`
+            });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return pending == 0; });
+    }
+
+    for (const ExecutionReport& report : trip.reports)
+    {
+        trip.tick_to_last_fill = std::max(trip.tick_to_last_fill, std::chrono::nanoseconds(report.received - tick));
+        if (report.filled <= 0.0) continue;
+
+        auto latency = std::chrono::nanoseconds(report.received - tick);
+        if (trip.tick_to_first_fill.count() == 0 || latency < trip.tick_to_first_fill) trip.tick_to_first_fill = latency;
+        Price fee_factor = (side == OrderSide::BUY) ? 1 + report.fee_rate : 1 - report.fee_rate;
+        trip.filled += report.filled;
+        trip.executed_total += report.filled * report.average_price * fee_factor;
+    }
+
+    Price planned = trip.plan.get_average_effective_price();
+    if (trip.filled > 0.0 && planned > 0.0)
+    {
+        Price executed = trip.executed_total / trip.filled;
+        trip.slippage_bps = ((side == OrderSide::BUY) ? executed - planned : planned - executed) / planned * 10000.0;
+    }
+    return trip;
+}
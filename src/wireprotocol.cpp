@@ -0,0 +1,193 @@
+#include "wireprotocol.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+template <typename T>
+void put(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_name(std::string& out, const ExchangeName& name)
+{
+    size_t length = std::min<size_t>(name.size(), UINT8_MAX);
+    put<uint8_t>(out, static_cast<uint8_t>(length));
+    out.append(name.data(), length);
+}
+
+// Writes the header with a placeholder length; finish_frame() patches it once the payload is known
+size_t begin_frame(std::string& out, uint32_t request_id, uint8_t code)
+{
+    size_t start = out.size();
+    put<uint32_t>(out, 0);
+    put<uint32_t>(out, request_id);
+    put<uint8_t>(out, code);
+    return start;
+}
+
+void finish_frame(std::string& out, size_t start)
+{
+    uint32_t payload_length = static_cast<uint32_t>(out.size() - start - WIRE_HEADER_SIZE);
+    std::memcpy(&out[start], &payload_length, sizeof(payload_length));
+}
+
+class Reader
+{
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+
+public:
+    Reader(const char* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    bool get(T& value)
+    {
+        if (m_size - m_offset < sizeof(T)) return false;
+        std::memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool get_name(ExchangeName& name)
+    {
+        uint8_t length;
+        if (!get(length) || m_size - m_offset < length) return false;
+        name.assign(m_data + m_offset, length);
+        m_offset += length;
+        return true;
+    }
+
+    bool done() const { return m_offset == m_size; }
+};
+
+bool decode_side(uint8_t raw, OrderSide& side)
+{
+    if (raw > static_cast<uint8_t>(OrderSide::SELL)) return false;
+    side = static_cast<OrderSide>(raw);
+    return true;
+}
+}
+
+void encode_order_request(std::string& out, uint32_t request_id, WireRequestType type, const WireOrderRequest& request)
+{
+    size_t start = begin_frame(out, request_id, static_cast<uint8_t>(type));
+    put<double>(out, request.size);
+    put<uint8_t>(out, static_cast<uint8_t>(request.side));
+    put<uint8_t>(out, static_cast<uint8_t>(request.algorithm));
+    put<uint64_t>(out, request.latency_budget_us);
+    finish_frame(out, start);
+}
+
+void encode_liquidity_request(std::string& out, uint32_t request_id, OrderSide side)
+{
+    size_t start = begin_frame(out, request_id, static_cast<uint8_t>(WireRequestType::LIQUIDITY));
+    put<uint8_t>(out, static_cast<uint8_t>(side));
+    finish_frame(out, start);
+}
+
+void encode_plan_response(std::string& out, uint32_t request_id, const ExecutionPlan& plan)
+{
+    size_t start = begin_frame(out, request_id, static_cast<uint8_t>(WireStatus::OK));
+    put<double>(out, plan.get_total());
+    put<double>(out, plan.get_total_fees());
+    put<double>(out, plan.get_average_effective_price());
+    put<uint32_t>(out, static_cast<uint32_t>(plan.get_plan().size()));
+    for (const FillOrder& fill : plan.get_plan()) 
+    {
+        put_name(out, fill.exchange_name);
+        put<double>(out, fill.price);
+        put<double>(out, fill.volume);
+    }
+    finish_frame(out, start);
+}
+
+void encode_liquidity_response(std::string& out, uint32_t request_id, const std::vector<VenueLiquidity>& liquidity)
+{
+    size_t start = begin_frame(out, request_id, static_cast<uint8_t>(WireStatus::OK));
+    put<uint32_t>(out, static_cast<uint32_t>(liquidity.size()));
+    for (const VenueLiquidity& venue : liquidity) 
+    {
+        put_name(out, venue.exchange_name);
+        put<double>(out, venue.best_price);
+        put<double>(out, venue.volume);
+        put<uint32_t>(out, static_cast<uint32_t>(venue.levels));
+    }
+    finish_frame(out, start);
+}
+
+void encode_error_response(std::string& out, uint32_t request_id, WireStatus status)
+{
+    finish_frame(out, begin_frame(out, request_id, static_cast<uint8_t>(status)));
+}
+
+bool decode_header(const char* data, size_t size, WireHeader& header)
+{
+    Reader reader(data, size);
+    return reader.get(header.payload_length) && reader.get(header.request_id) && reader.get(header.code);
+}
+
+bool decode_order_request(const char* payload, size_t size, WireOrderRequest& request)
+{
+    Reader reader(payload, size);
+    uint8_t side, algorithm;
+    if (!reader.get(request.size) || !reader.get(side) || !reader.get(algorithm) ||
+        !reader.get(request.latency_budget_us) || !reader.done()) 
+    {
+        return false;
+    }
+    if (!decode_side(side, request.side) || algorithm > static_cast<uint8_t>(RoutingAlgorithm::ADAPTIVE)) return false;
+    request.algorithm = static_cast<RoutingAlgorithm>(algorithm);
+    // Rejects NaN and infinity as well as non-positive sizes
+    return request.size > 0.0 && std::isfinite(request.size);
+}
+
+bool decode_liquidity_request(const char* payload, size_t size, OrderSide& side)
+{
+    Reader reader(payload, size);
+    uint8_t raw;
+    return reader.get(raw) && reader.done() && decode_side(raw, side);
+}
+
+bool decode_plan_response(const char* payload, size_t size, WirePlan& plan)
+{
+    Reader reader(payload, size);
+    uint32_t fill_count;
+    if (!reader.get(plan.total) || !reader.get(plan.fees) || !reader.get(plan.average_price) || !reader.get(fill_count)) 
+    {
+        return false;
+    }
+    plan.fills.clear();
+    for (uint32_t i = 0; i < fill_count; ++i) 
+    {
+        FillOrder fill;
+        if (!reader.get_name(fill.exchange_name) || !reader.get(fill.price) || !reader.get(fill.volume)) return false;
+        plan.fills.push_back(std::move(fill));
+    }
+    return reader.done();
+}
+
+bool decode_liquidity_response(const char* payload, size_t size, std::vector<VenueLiquidity>& liquidity)
+{
+    Reader reader(payload, size);
+    uint32_t venue_count;
+    if (!reader.get(venue_count)) return false;
+    liquidity.clear();
+    for (uint32_t i = 0; i < venue_count; ++i) 
+    {
+        VenueLiquidity venue;
+        uint32_t levels;
+        if (!reader.get_name(venue.exchange_name) || !reader.get(venue.best_price) || !reader.get(venue.volume) ||
+            !reader.get(levels)) 
+        {
+            return false;
+        }
+        venue.levels = levels;
+        liquidity.push_back(std::move(venue));
+    }
+    return reader.done();
+}
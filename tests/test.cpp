@@ -2,8 +2,28 @@
 #include "smartorderrouter.h"
 #include "orderbook.h"
 #include "utils.h"
+#include "symbolregistry.h"
+#include "routingengine.h"
+#include "batchrunner.h"
+#include "routingserver.h"
+#include "routingclient.h"
+#include "sor_c.h"
+#include "planjournal.h"
+#include "costcurves.h"
+#include "snapshotloader.h"
+#include "differential.h"
+#include "venuesimulator.h"
+#include "netting.h"
+#include <atomic>
+#include <limits>
 #include <memory>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 
 
 class SmartOrderRouterTest : public ::testing::Test {
@@ -147,4 +167,1164 @@ TEST(SmartOrderRouterTest, OptimizationShowcase2)
         total_quantity += fill.volume;
     }
     EXPECT_NEAR(total_quantity, 0.45, 1e-6);
-}
\ No newline at end of file
+}
+
+// Without a budget the optimizer completes its search and certifies the plan
+TEST(SmartOrderRouterTest, OptimizerProvesOptimality)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 5.0);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0002, 4.0);
+    exchange1->add_ask(100.0, 5.0);
+    exchange1->add_ask(101.0, 5.0);
+    exchange2->add_ask(100.6, 4.0);
+    exchange2->add_ask(100.8, 4.0);
+
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    ExecutionPlan execution_plan = router.distribute_order(8.0, OrderSide::BUY);
+
+    ASSERT_TRUE(execution_plan.is_optimizer_used());
+    EXPECT_TRUE(execution_plan.is_proven_optimal());
+    EXPECT_DOUBLE_EQ(execution_plan.get_optimality_gap(), 0.0);
+    EXPECT_NEAR(execution_plan.get_fulfillment_percentage(), 100.0, 1e-6);
+}
+
+// An expired budget returns the greedy-seeded incumbent without a proof
+TEST(SmartOrderRouterTest, OptimizerRespectsLatencyBudget)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 5.0);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0002, 4.0);
+    exchange1->add_ask(100.0, 5.0);
+    exchange1->add_ask(101.0, 5.0);
+    exchange2->add_ask(100.6, 4.0);
+    exchange2->add_ask(100.8, 4.0);
+
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    ExecutionPlan execution_plan = router.distribute_order(8.0, OrderSide::BUY, RoutingAlgorithm::HYBRID,
+                                                           std::chrono::microseconds(0));
+
+    ASSERT_TRUE(execution_plan.is_optimizer_used());
+    EXPECT_FALSE(execution_plan.is_proven_optimal());
+    EXPECT_GE(execution_plan.get_optimality_gap(), 0.0);
+    EXPECT_FALSE(execution_plan.get_plan().empty());
+    // The greedy seed fills 5 where 8 is reachable; the gap must say so even at zero cost gap
+    EXPECT_NEAR(execution_plan.get_fulfillment_percentage(), 62.5, 1e-6);
+    EXPECT_NEAR(execution_plan.get_optimality_volume_gap(), 3.0, 1e-9);
+}
+
+// Repeated residuals against unchanged books are served from the optimizer cache
+TEST(SmartOrderRouterTest, OptimizerCacheHitsUntilBookChanges)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 5.0);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0002, 4.0);
+    exchange1->add_ask(100.0, 5.0);
+    exchange1->add_ask(101.0, 5.0);
+    exchange2->add_ask(100.6, 4.0);
+    exchange2->add_ask(100.8, 4.0);
+
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+
+    // The optimizer takes over before the greedy pass touches the books, so the versions stay put
+    ExecutionPlan first = router.quote(8.0, OrderSide::BUY);
+    ExecutionPlan second = router.distribute_order(8.0, OrderSide::BUY);
+    EXPECT_EQ(router.get_optimizer_cache_stats().misses, 1u);
+    EXPECT_EQ(router.get_optimizer_cache_stats().hits, 1u);
+    EXPECT_NEAR(first.get_total(), second.get_total(), 1e-9);
+
+    // The executed order consumed the optimizer's fills
+    router.quote(8.0, OrderSide::BUY);
+    EXPECT_EQ(router.get_optimizer_cache_stats().invalidations, 1u);
+    EXPECT_EQ(router.get_optimizer_cache_stats().misses, 2u);
+    EXPECT_DOUBLE_EQ(router.get_optimizer_cache_stats().hit_rate(), 1.0 / 3.0);
+}
+
+// Each symbol routes against its own venue books with their own fee and lot configuration
+TEST(SmartOrderRouterTest, SymbolRegistryRoutesPerSymbol)
+{
+    SymbolRegistry registry;
+    SymbolId btc = registry.register_symbol("BTC-USDT");
+    SymbolId eth = registry.register_symbol("ETH-USDT");
+    EXPECT_EQ(registry.register_symbol("BTC-USDT"), btc);
+    EXPECT_EQ(registry.get_symbol_id("ETH-USDT"), eth);
+    EXPECT_THROW(registry.get_symbol_id("SOL-USDT"), std::out_of_range);
+
+    registry.add_venue(btc, {"Exchange1", 0.001, 1.0})->add_ask(100.0, 10.0);
+    registry.add_venue(eth, {"Exchange1", 0.002, 0.5})->add_ask(10.0, 10.0);
+    EXPECT_THROW(registry.add_venue(eth, {"Exchange1", 0.002, 0.5}), std::runtime_error);
+
+    ExecutionPlan execution_plan = registry.distribute_order(eth, 2.0, OrderSide::BUY);
+    ASSERT_EQ(execution_plan.get_plan().size(), 1);
+    EXPECT_EQ(execution_plan.get_plan()[0].price, 10.0);
+    EXPECT_NEAR(execution_plan.get_total_fees(), 2.0 * 10.0 * 0.002, 1e-9);
+
+    // The other symbol's book is untouched
+    EXPECT_EQ(registry.get_book(btc, "Exchange1")->get_best_ask().second, 10.0);
+    EXPECT_EQ(registry.get_book(eth, "Exchange1")->get_best_ask().second, 8.0);
+}
+
+// Quotes report the plan distribute_order would produce without consuming liquidity
+TEST(SmartOrderRouterTest, QuoteDoesNotMutateBooks)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 1.0);
+    exchange1->add_ask(100.0, 10.0);
+    exchange1->add_ask(101.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    ExecutionPlan quoted = router.quote(12.0, OrderSide::BUY);
+    EXPECT_EQ(exchange1->get_best_ask().second, 10.0);
+
+    ExecutionPlan executed = router.distribute_order(12.0, OrderSide::BUY);
+    ASSERT_EQ(quoted.get_plan().size(), executed.get_plan().size());
+    EXPECT_DOUBLE_EQ(quoted.get_total(), executed.get_total());
+    EXPECT_EQ(exchange1->get_best_ask().first, 101.0);
+}
+
+// Orders are routed on the owning shard in submission order, matching a single-threaded router
+TEST(SmartOrderRouterTest, RoutingEngineMatchesSequentialRouting)
+{
+    auto load = [](SymbolRegistry& registry) 
+    {
+        for (int s = 0; s < 4; ++s) 
+        {
+            SymbolId id = registry.register_symbol("SYM" + std::to_string(s));
+            auto book = registry.add_venue(id, {"Exchange1", 0.001, 0.1});
+            for (int level = 0; level < 5; ++level) 
+            {
+                book->add_ask(100.0 + s + level, 1.0);
+            }
+        }
+    };
+
+    SymbolRegistry sequential;
+    SymbolRegistry sharded;
+    load(sequential);
+    load(sharded);
+
+    std::vector<std::future<ExecutionPlan>> results;
+    {
+        RoutingEngine engine(sharded, 2);
+        EXPECT_EQ(engine.get_shard(3), 1u);
+        for (int i = 0; i < 12; ++i) 
+        {
+            results.push_back(engine.submit_order(static_cast<SymbolId>(i % 4), 0.7, OrderSide::BUY));
+            engine.submit_quote(static_cast<SymbolId>(i % 4), 2.0, OrderSide::BUY);
+        }
+        EXPECT_THROW(engine.submit_order(4, 1.0, OrderSide::BUY), std::out_of_range);
+
+        for (int i = 0; i < 12; ++i) 
+        {
+            ExecutionPlan expected = sequential.distribute_order(static_cast<SymbolId>(i % 4), 0.7, OrderSide::BUY);
+            EXPECT_DOUBLE_EQ(results[i].get().get_total(), expected.get_total());
+        }
+    }
+}
+
+// Concurrent routers sharing books must never hand out the same liquidity twice
+TEST(SmartOrderRouterTest, ConcurrentReservationsNeverDoubleBook)
+{
+    const std::vector<std::tuple<std::string, double, double>> venues = {
+        {"Exchange1", 0.001, 0.1}, {"Exchange2", 0.0005, 0.15}, {"Exchange3", 0.0002, 0.2}};
+
+    using LevelKey = std::pair<std::string, Price>;
+    std::unordered_map<std::string, std::shared_ptr<OrderBook>> order_books;
+    std::map<LevelKey, Volume> initial;
+    std::mt19937 rng(11);
+    for (const auto& [name, fee, min_size] : venues) 
+    {
+        auto book = std::make_shared<OrderBook>(name, fee, min_size);
+        for (int level = 0; level < 40; ++level) 
+        {
+            Price price = 100.0 + 0.01 * level + 0.001 * static_cast<int>(order_books.size());
+            Volume volume = 0.05 * static_cast<int>(rng() % 40 + 1);
+            book->add_ask(price, volume);
+            initial[{name, price}] = volume;
+        }
+        order_books.emplace(name, book);
+    }
+
+    // No level is inserted during the run, so level addresses identify claims
+    std::map<const PriceLevel*, LevelKey> level_keys;
+    for (const auto& [name, book] : order_books) 
+    {
+        for (const auto& [price, level] : book->get_asks()) 
+        {
+            level_keys[&level] = {name, price};
+        }
+    }
+
+    std::mutex results_mutex;
+    std::map<LevelKey, Volume> claimed;
+    std::map<LevelKey, Volume> filled;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) 
+    {
+        threads.emplace_back([&, t]() 
+        {
+            SmartOrderRouter router(order_books);
+            std::mt19937 thread_rng(t);
+            for (int i = 0; i < 60; ++i) 
+            {
+                Volume size = 0.05 * static_cast<int>(thread_rng() % 30 + 1);
+                RoutingAlgorithm algorithm = (i % 2 == 0) ? RoutingAlgorithm::HYBRID : RoutingAlgorithm::PURE_GREEDY;
+                LiquidityReservation reservation = router.reserve_order(size, OrderSide::BUY, algorithm);
+                if (thread_rng() % 4 == 0) 
+                {
+                    reservation.release();
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(results_mutex);
+                for (const LiquidityClaim& claim : reservation.get_claims()) 
+                {
+                    claimed[level_keys.at(claim.level)] += claim.volume;
+                }
+                ExecutionPlan plan = reservation.commit();
+                for (const FillOrder& fill : plan.get_plan()) 
+                {
+                    filled[{fill.exchange_name, fill.price}] += fill.volume;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) 
+    {
+        thread.join();
+    }
+
+    for (const auto& [key, initial_volume] : initial) 
+    {
+        Volume remaining = order_books.at(key.first)->get_ask_volume(key.second);
+        EXPECT_GE(remaining, 0.0) << key.first << " @ " << key.second;
+        // Every unit is either still resting or consumed by exactly one committed plan
+        EXPECT_NEAR(claimed[key] + remaining, initial_volume, 1e-9) << key.first << " @ " << key.second;
+        // Plans never fill more than they claimed (the difference is sub-lot remainder the book drops)
+        EXPECT_LE(filled[key], claimed[key] + 1e-9) << key.first << " @ " << key.second;
+    }
+}
+
+TEST(SmartOrderRouterTest, BatchModeStreamsPlans)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    exchange1->add_ask(100.0, 10.0);
+    exchange1->add_bid(99.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    std::istringstream input("size,side,algorithm\n1.5,BUY,H\n\n# comment\n2,sell,G\nbogus,BUY,H\nnan,BUY,H\ninf,SELL,G\n");
+    std::ostringstream output;
+    BatchSummary summary = run_batch(router, input, output, BatchFormat::JSON_LINES);
+
+    EXPECT_EQ(summary.orders, 2u);
+    EXPECT_EQ(summary.rejected, 3u);     // bogus, nan and inf sizes
+    EXPECT_EQ(summary.fills, 2u);
+    EXPECT_LE(summary.latency_p50_us, summary.latency_max_us);
+
+    std::string first, second;
+    std::istringstream lines(output.str());
+    std::getline(lines, first);
+    std::getline(lines, second);
+    EXPECT_EQ(first.rfind("{\"id\":1,\"algorithm\":\"HYBRID\",\"latency_us\":", 0), 0u);
+    EXPECT_NE(first.find(",\"side\":\"BUY\",\"requested\":1.50000000"), std::string::npos);
+    EXPECT_NE(first.find("\"exchange\":\"Exchange1\",\"price\":100.00000000,\"volume\":1.50000000"), std::string::npos);
+    EXPECT_NE(second.find("\"algorithm\":\"GREEDY\""), std::string::npos);
+    EXPECT_NE(second.find("\"side\":\"SELL\""), std::string::npos);
+    EXPECT_DOUBLE_EQ(exchange1->get_ask_volume(100.0), 8.5);
+
+    // Lines come from ExecutionPlan::append_json, so venue names are escaped
+    auto quoted = std::make_shared<OrderBook>("Ex\"1\\", 0.001, 0.1);
+    quoted->add_ask(100.0, 10.0);
+    SmartOrderRouter quoted_router({{quoted->get_exchange_name(), quoted}});
+    std::istringstream quoted_input("1,BUY,G\n");
+    std::ostringstream quoted_output;
+    run_batch(quoted_router, quoted_input, quoted_output, BatchFormat::JSON_LINES);
+    EXPECT_NE(quoted_output.str().find("\"exchange\":\"Ex\\\"1\\\\\""), std::string::npos) << quoted_output.str();
+}
+
+// Input that arrives one line at a time, like a producer waiting for each plan before the next order
+class LineByLineInput : public std::streambuf
+{
+public:
+    LineByLineInput(std::vector<std::string> lines, std::ostringstream& output) : m_lines(std::move(lines)), m_output(output) {}
+    std::vector<size_t> output_sizes;   // Output already written each time a new line was requested
+
+protected:
+    int_type underflow() override
+    {
+        output_sizes.push_back(m_output.str().size());
+        if (m_next == m_lines.size()) return traits_type::eof();
+        m_current = m_lines[m_next++];
+        setg(m_current.data(), m_current.data(), m_current.data() + m_current.size());
+        return traits_type::to_int_type(m_current[0]);
+    }
+
+private:
+    std::vector<std::string> m_lines;
+    std::ostringstream& m_output;
+    std::string m_current;
+    size_t m_next = 0;
+};
+
+TEST(SmartOrderRouterTest, BatchModeFlushesWhenInputStalls)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    exchange1->add_ask(100.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    std::ostringstream output;
+    LineByLineInput source({"1,BUY,G\n", "2,BUY,G\n", "3,BUY,G\n"}, output);
+    std::istream input(&source);
+    BatchSummary summary = run_batch(router, input, output, BatchFormat::JSON_LINES);
+
+    EXPECT_EQ(summary.orders, 3u);
+    ASSERT_EQ(source.output_sizes.size(), 4u);  // The last request finds the end of the input
+    for (size_t i = 1; i < source.output_sizes.size(); ++i) 
+    {
+        EXPECT_GT(source.output_sizes[i], source.output_sizes[i - 1]) << "plan " << i << " still buffered";
+    }
+}
+
+TEST(SmartOrderRouterTest, NettedBatchModeFlushesWhenInputStalls)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    exchange1->add_ask(100.0, 10.0);
+    exchange1->add_bid(99.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    // The window never fills, so each order is routed on its own once the producer stalls
+    std::ostringstream output;
+    LineByLineInput source({"1,BUY,G\n", "2,SELL,G\n", "3,BUY,G\n"}, output);
+    std::istream input(&source);
+    BatchSummary summary = run_batch(router, input, output, BatchFormat::JSON_LINES, nullptr, 4);
+
+    EXPECT_EQ(summary.orders, 3u);
+    EXPECT_EQ(summary.routing_calls, 3u);
+    ASSERT_EQ(source.output_sizes.size(), 4u);
+    for (size_t i = 1; i < source.output_sizes.size(); ++i) 
+    {
+        EXPECT_GT(source.output_sizes[i], source.output_sizes[i - 1]) << "plan " << i << " still buffered";
+    }
+}
+
+TEST(SmartOrderRouterTest, RoutingServerAnswersPipelinedRequests)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    exchange1->add_ask(100.0, 10.0);
+    exchange1->add_bid(99.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    std::string socket_path = (std::filesystem::temp_directory_path() / ("sor_test_" + std::to_string(getpid()) + ".sock")).string();
+    RoutingServer server(router);
+    server.listen_unix(socket_path);
+    std::thread server_thread([&server]() { server.run(); });
+
+    RoutingClient client;
+    client.connect_unix(socket_path);
+    std::string frames;
+    encode_order_request(frames, 1, WireRequestType::QUOTE, {2.0, OrderSide::BUY, RoutingAlgorithm::HYBRID});
+    encode_order_request(frames, 2, WireRequestType::DISTRIBUTE, {1.5, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY});
+    encode_liquidity_request(frames, 3, OrderSide::BUY);
+    encode_order_request(frames, 4, WireRequestType::QUOTE, {-1.0, OrderSide::BUY, RoutingAlgorithm::HYBRID});
+    client.send(frames);
+
+    WireHeader header;
+    std::string payload;
+    WirePlan plan;
+    ASSERT_TRUE(client.receive(header, payload));
+    EXPECT_EQ(header.request_id, 1u);
+    ASSERT_TRUE(decode_plan_response(payload.data(), payload.size(), plan));
+    ASSERT_EQ(plan.fills.size(), 1u);
+    EXPECT_DOUBLE_EQ(plan.fills[0].volume, 2.0);
+
+    ASSERT_TRUE(client.receive(header, payload));
+    EXPECT_EQ(header.request_id, 2u);
+    ASSERT_TRUE(decode_plan_response(payload.data(), payload.size(), plan));
+    EXPECT_NEAR(plan.total, 150.15, 1e-9);     // 1.5 @ 100 plus the 0.1% taker fee
+
+    std::vector<VenueLiquidity> liquidity;
+    ASSERT_TRUE(client.receive(header, payload));
+    EXPECT_EQ(header.request_id, 3u);
+    ASSERT_TRUE(decode_liquidity_response(payload.data(), payload.size(), liquidity));
+    ASSERT_EQ(liquidity.size(), 1u);
+    EXPECT_DOUBLE_EQ(liquidity[0].best_price, 100.0);
+    EXPECT_DOUBLE_EQ(liquidity[0].volume, 8.5);    // Only the distribute consumed liquidity
+
+    ASSERT_TRUE(client.receive(header, payload));
+    EXPECT_EQ(header.request_id, 4u);
+    EXPECT_EQ(header.code, static_cast<uint8_t>(WireStatus::BAD_REQUEST));
+    // Infinite and NaN sizes are rejected like negative ones
+    for (Volume size : {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()}) 
+    {
+        std::string frame;
+        WireOrderRequest request;
+        encode_order_request(frame, 5, WireRequestType::QUOTE, {size, OrderSide::BUY, RoutingAlgorithm::HYBRID});
+        EXPECT_FALSE(decode_order_request(frame.data() + WIRE_HEADER_SIZE, frame.size() - WIRE_HEADER_SIZE, request));
+    }
+
+    client.close();
+    server.stop();
+    server_thread.join();
+    EXPECT_EQ(server.get_requests_served(), 4u);
+
+    // A client that half-closes after its last request still gets every answer, then EOF. The requests
+    // fill exactly one 64 KiB server read and are queued before the server runs again, so the EOF is
+    // seen in the same read as complete, unanswered frames
+    constexpr size_t SERVER_READ_SIZE = 64 << 10;
+    std::string quote;
+    encode_order_request(quote, 0, WireRequestType::QUOTE, {1.0, OrderSide::SELL, RoutingAlgorithm::HYBRID});
+    frames.clear();
+    uint32_t requests = 0;
+    while ((SERVER_READ_SIZE - frames.size()) % quote.size() != 0) encode_liquidity_request(frames, ++requests, OrderSide::BUY);
+    while (frames.size() < SERVER_READ_SIZE) 
+    {
+        encode_order_request(frames, ++requests, WireRequestType::QUOTE, {1.0, OrderSide::SELL, RoutingAlgorithm::HYBRID});
+    }
+    RoutingClient half_closed;
+    half_closed.connect_unix(socket_path);
+    half_closed.send(frames);
+    half_closed.finish_sending();
+
+    server_thread = std::thread([&server]() { server.run(); });
+    uint32_t answered = 0;
+    while (half_closed.receive(header, payload)) 
+    {
+        EXPECT_EQ(header.request_id, ++answered);
+        EXPECT_EQ(header.code, static_cast<uint8_t>(WireStatus::OK));
+    }
+    EXPECT_EQ(answered, requests);
+
+    server.stop();
+    server_thread.join();
+    EXPECT_EQ(server.get_requests_served(), 4u + requests);
+}
+
+TEST(SmartOrderRouterTest, CApiRoutesThroughCallerBuffers)
+{
+    sor_router* router = sor_router_create();
+    ASSERT_NE(router, nullptr);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, 0.1), SOR_OK);
+    EXPECT_EQ(sor_add_venue(router, "Exchange2", 0.0005, 0.1), SOR_OK);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, 0.1), SOR_DUPLICATE_VENUE);
+    EXPECT_EQ(sor_set_level(router, "Exchange1", SOR_ASK, 100.0, 1.0), SOR_OK);
+    EXPECT_EQ(sor_set_level(router, "Exchange2", SOR_ASK, 101.0, 5.0), SOR_OK);
+    EXPECT_EQ(sor_set_level(router, "Missing", SOR_ASK, 101.0, 5.0), SOR_UNKNOWN_VENUE);
+
+    sor_fill fills[2];
+    sor_plan_summary summary;
+    // One slot is too few: nothing is consumed and the required count is reported
+    EXPECT_EQ(sor_distribute_order(router, 2.0, SOR_BUY, SOR_PURE_GREEDY, SOR_NO_LATENCY_BUDGET, fills, 1, &summary),
+              SOR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(summary.fill_count, 2u);
+
+    ASSERT_EQ(sor_distribute_order(router, 2.0, SOR_BUY, SOR_PURE_GREEDY, SOR_NO_LATENCY_BUDGET, fills, 2, &summary), SOR_OK);
+    ASSERT_EQ(summary.fill_count, 2u);
+    EXPECT_STREQ(fills[0].exchange_name, "Exchange1");
+    EXPECT_DOUBLE_EQ(fills[0].volume, 1.0);
+    EXPECT_STREQ(fills[1].exchange_name, "Exchange2");
+    EXPECT_DOUBLE_EQ(summary.filled_volume, 2.0);
+
+    sor_venue_liquidity venues[2];
+    size_t venue_count = 0;
+    ASSERT_EQ(sor_get_liquidity(router, SOR_BUY, venues, 2, &venue_count), SOR_OK);
+    ASSERT_EQ(venue_count, 2u);
+    EXPECT_EQ(venues[0].levels, 0u);
+    EXPECT_DOUBLE_EQ(venues[1].volume, 4.0);
+
+    // Book updates replace the resting volume
+    EXPECT_EQ(sor_set_level(router, "Exchange1", SOR_ASK, 99.0, 3.0), SOR_OK);
+    ASSERT_EQ(sor_quote(router, 1.0, SOR_BUY, SOR_HYBRID, 1000, fills, 2, &summary), SOR_OK);
+    EXPECT_DOUBLE_EQ(fills[0].price, 99.0);
+    EXPECT_EQ(sor_quote(router, -1.0, SOR_BUY, SOR_HYBRID, 1000, fills, 2, &summary), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_quote(router, std::numeric_limits<double>::quiet_NaN(), SOR_BUY, SOR_HYBRID, 1000, fills, 2, &summary),
+              SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_distribute_order(router, std::numeric_limits<double>::infinity(), SOR_BUY, SOR_PURE_GREEDY,
+                                   SOR_NO_LATENCY_BUDGET, fills, 2, &summary), SOR_INVALID_ARGUMENT);
+
+    sor_router_destroy(router);
+}
+
+TEST(SmartOrderRouterTest, CApiRejectsInvalidVenues)
+{
+    sor_router* router = sor_router_create();
+    ASSERT_NE(router, nullptr);
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, 0.0), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, -0.1), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, nan), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, infinity), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", -0.001, 0.1), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", nan, 0.1), SOR_INVALID_ARGUMENT);
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", infinity, 0.1), SOR_INVALID_ARGUMENT);
+
+    // None of the rejected venues was added, so routing still terminates
+    EXPECT_EQ(sor_add_venue(router, "Exchange1", 0.001, 0.1), SOR_OK);
+    EXPECT_EQ(sor_add_venue(router, "Exchange2", 0.0, 0.1), SOR_OK);
+    EXPECT_EQ(sor_set_level(router, "Exchange1", SOR_ASK, 100.0, 1.0), SOR_OK);
+    EXPECT_EQ(sor_set_level(router, "Exchange2", SOR_ASK, 101.0, 1.0), SOR_OK);
+    sor_fill fills[2];
+    sor_plan_summary summary;
+    ASSERT_EQ(sor_quote(router, 1.5, SOR_BUY, SOR_PURE_GREEDY, SOR_NO_LATENCY_BUDGET, fills, 2, &summary), SOR_OK);
+    EXPECT_EQ(summary.fill_count, 2u);
+
+    sor_router_destroy(router);
+}
+
+TEST(SmartOrderRouterTest, PlanJournalRoundTrips)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.01);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.01);
+    for (int level = 0; level < 10; ++level) 
+    {
+        exchange1->add_ask(100.0 + level, 1.0);
+        exchange2->add_ask(100.5 + level, 1.0);
+    }
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+
+    std::string path = (std::filesystem::temp_directory_path() / ("sor_test_" + std::to_string(getpid()) + ".journal")).string();
+    std::vector<ExecutionPlan> plans;
+    {
+        PlanJournal journal(path, 1 << 20, 4);
+        plans.push_back(router.distribute_order(1.5, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY));
+        ASSERT_TRUE(journal.record(plans.back()));
+        // The second plan sweeps enough levels to span more than one ring slot
+        plans.push_back(router.distribute_order(12.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY));
+        journal.flush();
+        ASSERT_TRUE(journal.record(plans.back()));
+        journal.flush();
+        EXPECT_EQ(journal.get_written(), 2u);
+    }
+
+    JournalContents contents = read_journal(path);
+    std::filesystem::remove(path);
+    EXPECT_EQ(contents.header.plans, 2u);
+    EXPECT_EQ(contents.header.dropped, 0u);
+    ASSERT_EQ(contents.entries.size(), 2u);
+    for (size_t i = 0; i < plans.size(); ++i) 
+    {
+        const JournalEntry& entry = contents.entries[i];
+        EXPECT_EQ(entry.sequence, i);
+        EXPECT_EQ(entry.side, OrderSide::BUY);
+        EXPECT_DOUBLE_EQ(entry.total, plans[i].get_total());
+        ASSERT_EQ(entry.fills.size(), plans[i].get_plan().size());
+        for (size_t f = 0; f < entry.fills.size(); ++f) 
+        {
+            EXPECT_EQ(entry.fills[f].exchange_name, plans[i].get_plan()[f].exchange_name);
+            EXPECT_DOUBLE_EQ(entry.fills[f].price, plans[i].get_plan()[f].price);
+            EXPECT_DOUBLE_EQ(entry.fills[f].volume, plans[i].get_plan()[f].volume);
+        }
+    }
+    EXPECT_GT(contents.entries[1].fills.size(), 8u);     // More fills than one ring slot holds
+}
+
+TEST(SmartOrderRouterTest, FullPlanJournalNeverReferencesMissingVenues)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.01);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.01);
+    for (int level = 0; level < 10; ++level) 
+    {
+        exchange1->add_ask(100.0 + level, 1.0);
+        exchange2->add_ask(100.5 + level, 1.0);
+    }
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    SmartOrderRouter exchange2_router({{"Exchange2", exchange2}});
+
+    // Room for one venue record and one single-fill plan plus 100 spare bytes
+    std::string path = (std::filesystem::temp_directory_path() / ("sor_test_full_" + std::to_string(getpid()) + ".journal")).string();
+    {
+        PlanJournal journal(path, sizeof(JournalFileHeader) + 220, 16);
+        ASSERT_TRUE(journal.record(router.distribute_order(1.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY)));
+        // Introduces Exchange2 but cannot fit, so its venue record is not written either
+        ASSERT_TRUE(journal.record(router.distribute_order(12.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY)));
+        // Small enough for the spare bytes, but it would reference the missing Exchange2 record
+        ASSERT_TRUE(journal.record(exchange2_router.distribute_order(1.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY)));
+        journal.flush();
+        EXPECT_EQ(journal.get_written(), 1u);
+        EXPECT_EQ(journal.get_dropped(), 2u);
+    }
+
+    JournalContents contents = read_journal(path);
+    std::filesystem::remove(path);
+    EXPECT_EQ(contents.header.plans, 1u);
+    EXPECT_EQ(contents.header.dropped, 2u);
+    ASSERT_EQ(contents.entries.size(), 1u);
+    ASSERT_EQ(contents.entries[0].fills.size(), 1u);
+    EXPECT_EQ(contents.entries[0].fills[0].exchange_name, "Exchange1");
+}
+
+TEST(SmartOrderRouterTest, EventLogHonoursRuntimeLevel)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    exchange1->add_ask(100.0, 10.0);
+    SmartOrderRouter router({{"Exchange1", exchange1}});
+
+    std::ostringstream output;
+    LogLevel previous_level = EventLog::get_level();
+    EventLog::instance().set_output(output);
+
+    EventLog::set_level(LogLevel::OFF);
+    router.quote(1.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY);
+    EventLog::instance().flush();
+    EXPECT_EQ(output.str(), "");
+
+    EventLog::set_level(LogLevel::DEBUG);
+    router.quote(1.0, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY);
+    SOR_LOG(LogLevel::INFO, "Venue {} has {} levels, best {}", std::string("Exchange1"), 1u, 100.0);
+    SOR_LOG(LogLevel::TRACE, "Below the threshold");
+    EventLog::instance().flush();
+
+    EventLog::set_level(previous_level);
+    EventLog::instance().set_output(std::cerr);
+
+    std::string text = output.str();
+    EXPECT_NE(text.find("DEBUG Initial Order: Size = 1, Type = Buy"), std::string::npos);
+    EXPECT_NE(text.find("DEBUG Added to execution plan: Exchange = Exchange1, Price = 100, Quantity = 1, Remaining = 0"), std::string::npos);
+    EXPECT_NE(text.find("INFO Venue Exchange1 has 1 levels, best 100"), std::string::npos);
+    EXPECT_EQ(text.find("TRACE"), std::string::npos);
+}
+
+TEST(SmartOrderRouterTest, ParallelOptimizerMatchesSerial)
+{
+    // A venue with a large minimum lot leaves a residual of hundreds of small lots for the optimizer
+    std::mt19937 rng(11);
+    std::unordered_map<std::string, std::shared_ptr<OrderBook>> order_books;
+    const double min_sizes[] = {4.0, 0.01, 0.02, 0.05};
+    for (size_t v = 0; v < 4; ++v) 
+    {
+        auto book = std::make_shared<OrderBook>("Exchange" + std::to_string(v), 0.0002 * (v + 1), min_sizes[v]);
+        for (int level = 0; level < 30; ++level) 
+        {
+            book->add_ask(100.0 + 0.01 * (rng() % 300), 0.05 + 0.01 * (rng() % 100));
+        }
+        order_books[book->get_exchange_name()] = book;
+    }
+    SmartOrderRouter serial(order_books);
+    SmartOrderRouter parallel(order_books);
+    serial.set_parallel_optimizer_threshold(SIZE_MAX);
+    parallel.set_parallel_optimizer_threshold(0);
+
+    ExecutionPlan expected = serial.quote(3.37, OrderSide::BUY);
+    ExecutionPlan actual = parallel.quote(3.37, OrderSide::BUY);
+    ASSERT_TRUE(expected.is_proven_optimal());
+    EXPECT_TRUE(actual.is_proven_optimal());
+    ASSERT_EQ(actual.get_plan().size(), expected.get_plan().size());
+    for (size_t i = 0; i < expected.get_plan().size(); ++i) 
+    {
+        EXPECT_EQ(actual.get_plan()[i].exchange_name, expected.get_plan()[i].exchange_name);
+        EXPECT_EQ(actual.get_plan()[i].price, expected.get_plan()[i].price);
+        EXPECT_EQ(actual.get_plan()[i].volume, expected.get_plan()[i].volume);
+    }
+
+    // The merge tree is fixed, so the pool size cannot change the result
+    std::vector<VenueCostCurve> curves;
+    for (size_t v = 0; v < 6; ++v) 
+    {
+        VenueCostCurve curve{0.01 * static_cast<double>(v + 1), {0.0}};
+        for (int k = 0; k < 200; ++k) 
+        {
+            curve.cumulative_cost.push_back(curve.cumulative_cost.back() + curve.lot_size * (100.0 + 0.01 * (rng() % 500)));
+        }
+        curves.push_back(curve);
+    }
+    ThreadPool pool(4);
+    CostCurveSolution single, pooled;
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    ASSERT_TRUE(solve_cost_curves(curves, 12.345, nullptr, deadline, single));
+    ASSERT_TRUE(solve_cost_curves(curves, 12.345, &pool, deadline, pooled));
+    EXPECT_EQ(single.lots_per_venue, pooled.lots_per_venue);
+    EXPECT_EQ(single.cost, pooled.cost);
+
+    // One merge over a full-width grid takes far longer than the budget; it must give up mid-level
+    std::vector<VenueCostCurve> wide(2, VenueCostCurve{0.0001, {0.0}});
+    for (VenueCostCurve& curve : wide) 
+    {
+        for (int k = 0; k < 16000; ++k) 
+        {
+            curve.cumulative_cost.push_back(curve.cumulative_cost.back() + curve.lot_size * (100.0 + 0.01 * (rng() % 500)));
+        }
+    }
+    CostCurveSolution untouched = single;
+    EXPECT_FALSE(solve_cost_curves(wide, 1.6, &pool, std::chrono::steady_clock::now() + std::chrono::milliseconds(1), untouched));
+    EXPECT_EQ(untouched.lots_per_venue, single.lots_per_venue);
+}
+
+// Saved differential cases: no algorithm beats the exhaustive reference and HYBRID never trails PURE_GREEDY
+TEST(SmartOrderRouterTest, DifferentialCasesRespectReference)
+{
+    std::filesystem::path data_dir = std::filesystem::path(__FILE__).parent_path() / "testdata/differential";
+    size_t cases = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(data_dir)) 
+    {
+        DifferentialResult result = run_differential(load_case(entry.path().string()));
+        SCOPED_TRACE(entry.path().filename().string());
+        for (RoutingAlgorithm algorithm : {RoutingAlgorithm::PURE_GREEDY, RoutingAlgorithm::HYBRID}) 
+        {
+            EXPECT_GE(get_fulfillment_gap(result, algorithm), -1e-6);
+            if (std::abs(get_fulfillment_gap(result, algorithm)) <= 1e-6) 
+            {
+                EXPECT_GE(get_cost_gap(result, algorithm), -1e-6);
+            }
+        }
+        EXPECT_GE(result.hybrid.volume, result.greedy.volume - 1e-6);
+        ++cases;
+    }
+    EXPECT_GT(cases, 0u);
+
+    // A level holding a whole number of lots must offer all of them to the optimizer
+    DifferentialResult whole_lots = run_differential(load_case((data_dir / "whole_lot_level").string()));
+    EXPECT_FALSE(diverges(whole_lots, RoutingAlgorithm::HYBRID));
+}
+
+// Running totals follow every mutation path and agree with a walk over the levels
+TEST(SmartOrderRouterTest, LiquiditySnapshotTracksBookUpdates)
+{
+    auto book = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    std::mt19937 rng(11);
+    for (int i = 0; i < 2000; ++i) 
+    {
+        Price price = 100.0 + 0.01 * static_cast<double>(rng() % 40);
+        Volume volume = 0.05 * static_cast<double>(1 + rng() % 20);
+        switch (rng() % 4) 
+        {
+            case 0: book->add_ask(price, volume); break;
+            case 1: book->add_bid(price - 1.0, volume); break;
+            case 2: book->reduce_ask_volume(price, volume); break;
+            default: book->set_bid_volume(price - 1.0, (rng() % 3 == 0) ? 0.0 : volume); break;
+        }
+    }
+
+    SmartOrderRouter router({{"Exchange1", book}});
+    LiquidityReservation reservation = router.reserve_order(1.0, OrderSide::BUY);
+    auto check = [&book]() 
+    {
+        LiquiditySnapshot snapshot = book->get_liquidity_snapshot();
+        for (bool bids : {true, false}) 
+        {
+            const SideLiquidity& side = bids ? snapshot.bids : snapshot.asks;
+            Volume volume = 0.0;
+            Price notional = 0.0;
+            size_t levels = 0;
+            for (const auto& [price, level] : bids ? book->get_bids() : book->get_asks()) 
+            {
+                if (level.load() <= 0.0) continue;
+                volume += level.load();
+                notional += price * level.load();
+                ++levels;
+            }
+            EXPECT_EQ(side.levels, levels);
+            EXPECT_NEAR(side.volume, volume, 1e-9);
+            EXPECT_NEAR(side.notional, notional, 1e-7);
+        }
+        EXPECT_EQ(snapshot.bids.best_price, book->get_best_bid().first);
+        EXPECT_EQ(snapshot.asks.best_price, book->get_best_ask().first);
+    };
+    check();
+    reservation.release();
+    check();
+    router.distribute_order(0.7, OrderSide::SELL);
+    check();
+    EXPECT_EQ(router.get_liquidity(OrderSide::BUY)[0].levels, book->get_liquidity_snapshot().asks.levels);
+}
+
+// Levels outside the depth and band window are parked cold and promoted as the top is consumed
+TEST(SmartOrderRouterTest, DepthLimitedBookPromotesColdLevels)
+{
+    auto book = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    book->set_depth_limits({3, 100.0});    // 3 levels within 1% of the best price
+    for (int i = 0; i < 10; ++i) 
+    {
+        book->add_ask(100.0 + 0.1 * i, 1.0);
+    }
+    book->add_ask(102.5, 5.0);
+
+    LiquiditySnapshot snapshot = book->get_liquidity_snapshot();
+    EXPECT_EQ(book->get_asks().size(), 3u);
+    EXPECT_EQ(snapshot.asks.levels, 3u);
+    EXPECT_EQ(snapshot.asks.cold_levels, 8u);
+    EXPECT_NEAR(snapshot.asks.cold_volume, 12.0, 1e-9);
+    EXPECT_DOUBLE_EQ(book->get_ask_volume(102.5), 5.0);
+
+    // A better price recentres the window and pushes the worst hot level out
+    book->add_ask(99.9, 1.0);
+    EXPECT_EQ(book->get_asks().begin()->first, 99.9);
+    EXPECT_EQ(book->get_asks().rbegin()->first, 100.1);
+
+    SmartOrderRouter router({{"Exchange1", book}});
+    ExecutionPlan plan = router.distribute_order(2.0, OrderSide::BUY);
+    EXPECT_NEAR(plan.get_fulfillment_percentage(), 100.0, 1e-6);
+    EXPECT_EQ(book->get_asks().size(), 3u);
+    EXPECT_EQ(book->get_asks().begin()->first, 100.1);
+    EXPECT_EQ(book->get_liquidity_snapshot().asks.cold_levels, 7u);
+
+    // An order larger than the window stops at it and reports the part the cold store held
+    ExecutionPlan capped = router.quote(6.0, OrderSide::BUY);
+    EXPECT_NEAR(capped.get_fulfillment_percentage(), 50.0, 1e-6);
+    EXPECT_NEAR(capped.get_depth_limited_volume(), 3.0, 1e-9);
+    EXPECT_NEAR(router.quote(20.0, OrderSide::BUY).get_depth_limited_volume(), 11.0, 1e-9);
+    EXPECT_DOUBLE_EQ(plan.get_depth_limited_volume(), 0.0);
+
+    // Lifting the limits promotes everything back
+    book->set_depth_limits({});
+    EXPECT_EQ(book->get_asks().size(), 10u);
+    EXPECT_EQ(book->get_liquidity_snapshot().asks.cold_levels, 0u);
+}
+
+// Updates made while a reservation is outstanding zero levels instead of waiting for the claims
+TEST(SmartOrderRouterTest, BookUpdatesDoNotWaitForPendingClaims)
+{
+    auto book = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    for (int i = 0; i < 4; ++i) 
+    {
+        book->add_ask(100.0 + i, 1.0);
+    }
+    SmartOrderRouter router({{"Exchange1", book}});
+    LiquidityReservation reservation = router.reserve_order(1.5, OrderSide::BUY);
+
+    // The same thread holds the claims, so any wait here would never return
+    book->set_ask_volume(100.0, 0.0);
+    book->remove_top_ask();
+    book->set_depth_limits({1, 0.0});
+    book->add_ask(103.0, 1.0);
+    EXPECT_EQ(book->get_asks().size(), 4u);       // Nothing erased or demoted yet
+    EXPECT_EQ(book->get_best_ask().first, 102.0);
+
+    reservation.commit();
+    EXPECT_EQ(book->get_asks().size(), 1u);
+    EXPECT_EQ(book->get_best_ask().first, 102.0);
+    EXPECT_EQ(book->get_liquidity_snapshot().asks.cold_levels, 1u);
+    EXPECT_NEAR(book->get_liquidity_snapshot().asks.volume, 1.0, 1e-9);
+}
+
+// Manifest venues are loaded in parallel into the registry with a timing per file
+TEST(SmartOrderRouterTest, ManifestLoaderBuildsRegistry)
+{
+    std::filesystem::path data_dir = std::filesystem::absolute(std::filesystem::path(__FILE__).parent_path() / "testdata/force_optimized");
+    std::string manifest_path = testing::TempDir() + "sor_manifest_" + std::to_string(getpid()) + ".csv";
+    {
+        std::ofstream manifest(manifest_path);
+        manifest << "Symbol,Exchange,TakerFee,MinOrderSize,File\n";
+        for (const char* symbol : {"SYM-A", "SYM-B"}) 
+        {
+            manifest << symbol << ",Binance,0.001,0.1," << (data_dir / "binance_order_book.csv").string() << "\n";
+            manifest << symbol << ",KuCoin,0.0005,0.15," << (data_dir / "kucoin_order_book.csv").string() << "\n";
+            manifest << symbol << ",OKX,0.0002,0.2," << (data_dir / "okx_order_book.csv").string() << "\n";
+        }
+        manifest << "SYM-B,Missing,0.001,0.1,missing_order_book.csv\n";
+    }
+
+    SymbolRegistry registry;
+    ThreadPool pool(3);
+    LoadReport report = load_snapshots(registry, read_manifest(manifest_path), pool);
+    std::remove(manifest_path.c_str());
+
+    ASSERT_EQ(report.files.size(), 7u);
+    EXPECT_EQ(report.failed, 1u);
+    EXPECT_EQ(report.files[6].exchange_name, "Missing");
+    EXPECT_FALSE(report.files[6].error.empty());
+    EXPECT_EQ(report.files[0].rows, 6u);
+    EXPECT_EQ(registry.size(), 2u);
+
+    // Books are complete once load_snapshots returns
+    ExecutionPlan plan = registry.distribute_order(registry.get_symbol_id("SYM-B"), 0.45, OrderSide::BUY);
+    EXPECT_NEAR(plan.get_fulfillment_percentage(), 100.0, 1e-6);
+}
+
+// A zero min order size would make routing loop forever, so such rows are rejected up front
+TEST(SmartOrderRouterTest, ManifestRejectsInvalidFeesAndMinOrderSizes)
+{
+    std::string manifest_path = testing::TempDir() + "sor_bad_manifest_" + std::to_string(getpid()) + ".csv";
+    for (const char* row : {"SYM,Binance,0.001,0,book.csv", "SYM,Binance,0.001,-0.1,book.csv", "SYM,Binance,0.001,nan,book.csv",
+                            "SYM,Binance,0.001,inf,book.csv", "SYM,Binance,-0.001,0.1,book.csv", "SYM,Binance,inf,0.1,book.csv",
+                            "SYM,Binance,nan,0.1,book.csv"}) 
+    {
+        {
+            std::ofstream manifest(manifest_path);
+            manifest << "Symbol,Exchange,TakerFee,MinOrderSize,File\n";
+            manifest << "SYM,KuCoin,0.0005,0.15,book.csv\n" << row << "\n";
+        }
+        try 
+        {
+            read_manifest(manifest_path);
+            ADD_FAILURE() << "accepted " << row;
+        } 
+        catch (const std::runtime_error& e) 
+        {
+            EXPECT_NE(std::string(e.what()).find("Malformed fee or min order size on manifest row 3"), std::string::npos) << e.what();
+        }
+    }
+    std::remove(manifest_path.c_str());
+}
+
+// Ladder quotes are served from the cache until a book changes on the side they price
+TEST(SmartOrderRouterTest, QuoteLadderRefreshesOnSideChanges)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.15);
+    for (int i = 0; i < 20; ++i) 
+    {
+        exchange1->add_ask(100.0 + 0.05 * i, 0.7);
+        exchange2->add_ask(100.02 + 0.05 * i, 0.9);
+        exchange1->add_bid(99.9 - 0.05 * i, 0.7);
+        exchange2->add_bid(99.92 - 0.05 * i, 0.9);
+    }
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    router.set_quote_ladder({0.1, 0.5, 1.0, 5.0, 10.0});
+
+    ExecutionPlan cached = router.quote(5.0, OrderSide::BUY);
+    ExecutionPlan fresh = router.quote(5.0, OrderSide::BUY, RoutingAlgorithm::HYBRID, std::chrono::seconds(10));
+    EXPECT_DOUBLE_EQ(cached.get_total(), fresh.get_total());
+    router.quote(1.0, OrderSide::BUY);
+    router.quote(0.5, OrderSide::SELL);
+    router.quote(0.7, OrderSide::BUY);     // Not on the ladder
+    QuoteLadderStats stats = router.get_quote_ladder_stats();
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_GT(stats.refresh_time.count(), 0);
+
+    // Consuming asks invalidates the BUY ladder only
+    router.distribute_order(0.5, OrderSide::BUY);
+    router.quote(0.5, OrderSide::SELL);
+    std::vector<LadderQuote> ladder = router.get_quote_ladder(OrderSide::BUY);
+    stats = router.get_quote_ladder_stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 3u);
+    ASSERT_EQ(ladder.size(), 5u);
+    EXPECT_NEAR(ladder[2].filled, 1.0, 1e-9);
+    EXPECT_DOUBLE_EQ(ladder[3].total, router.quote(5.0, OrderSide::BUY, RoutingAlgorithm::HYBRID, std::chrono::seconds(10)).get_total());
+
+    // Lookups never lock: quoting threads race with book updates and with each other's rebuilds
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> quoters;
+    for (int t = 0; t < 4; ++t) 
+    {
+        quoters.emplace_back([&router, &stop]() 
+        {
+            while (!stop.load()) 
+            {
+                ExecutionPlan plan = router.quote(1.0, OrderSide::BUY);
+                EXPECT_NEAR(plan.get_fulfillment_percentage(), 100.0, 1e-6);
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i) 
+    {
+        exchange1->add_ask(100.0, 0.01);
+        std::this_thread::yield();
+    }
+    stop.store(true);
+    for (std::thread& quoter : quoters) quoter.join();
+    // Whatever rebuild finished last, the ladder now reflects every update
+    EXPECT_DOUBLE_EQ(router.quote(1.0, OrderSide::BUY).get_total(),
+                     router.quote(1.0, OrderSide::BUY, RoutingAlgorithm::HYBRID, std::chrono::seconds(10)).get_total());
+}
+
+// Plans carry their own fees and totals, and round-trip through the binary and JSON encodings
+TEST(SmartOrderRouterTest, ExecutionPlanEncodesCompactly)
+{
+    ExecutionPlan plan(OrderSide::SELL, 2.0);
+    plan.add_fill(FillOrder("Exchange1", 100.0, 1.0, 0.001));
+    plan.add_fill(FillOrder("Ex\"2", 99.0, 0.5, 0.002));
+    plan.set_optimality(false, 0.25);
+    EXPECT_DOUBLE_EQ(plan.get_plan()[0].effective_price, 99.9);
+    EXPECT_DOUBLE_EQ(plan.get_total(), 99.9 + 0.5 * 99.0 * 0.998);
+    EXPECT_DOUBLE_EQ(plan.get_total_fees(), 0.1 + 0.5 * 99.0 * 0.002);
+    EXPECT_DOUBLE_EQ(plan.get_fulfillment_percentage(), 75.0);
+
+    std::string encoded;
+    plan.encode(encoded);
+    encoded += "tail";
+    ExecutionPlan decoded(OrderSide::BUY, 0.0);
+    size_t consumed = 0;
+    ASSERT_TRUE(ExecutionPlan::decode(encoded.data(), encoded.size(), decoded, consumed));
+    EXPECT_EQ(consumed, encoded.size() - 4);
+    EXPECT_EQ(decoded.get_side(), OrderSide::SELL);
+    EXPECT_DOUBLE_EQ(decoded.get_total(), plan.get_total());
+    EXPECT_DOUBLE_EQ(decoded.get_average_effective_price(), plan.get_average_effective_price());
+    EXPECT_TRUE(decoded.is_optimizer_used());
+    EXPECT_FALSE(decoded.is_proven_optimal());
+    ASSERT_EQ(decoded.get_plan().size(), 2u);
+    EXPECT_EQ(decoded.get_plan()[1].exchange_name, "Ex\"2");
+    EXPECT_DOUBLE_EQ(decoded.get_plan()[1].fee_rate, 0.002);
+    EXPECT_FALSE(ExecutionPlan::decode(encoded.data(), consumed - 1, decoded, consumed));
+
+    std::string json = plan.to_json();
+    EXPECT_NE(json.find("\"side\":\"SELL\""), std::string::npos);
+    EXPECT_NE(json.find("\"exchange\":\"Ex\\\"2\""), std::string::npos);
+    EXPECT_NE(json.find("\"proven_optimal\":false"), std::string::npos);
+}
+
+// Child orders travel to the simulated venues and back; partial fills show up as unfilled volume
+TEST(SmartOrderRouterTest, VenueSimulatorReportsTickToFill)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.1);
+    for (int i = 0; i < 10; ++i) 
+    {
+        exchange1->add_ask(100.0 + 0.1 * i, 0.5);
+        exchange2->add_ask(100.05 + 0.1 * i, 0.5);
+    }
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    VenueBehaviour behaviour;
+    behaviour.latency = std::chrono::microseconds(200);
+    std::vector<std::unique_ptr<VenueSimulator>> venues;
+    venues.push_back(std::make_unique<VenueSimulator>(*exchange1, behaviour));
+    behaviour.partial_fill_probability = 1.0;
+    venues.push_back(std::make_unique<VenueSimulator>(*exchange2, behaviour));
+    SimulationDriver driver(router, venues);
+
+    RoundTrip trip = driver.execute(1.0, OrderSide::BUY);
+    ASSERT_EQ(trip.reports.size(), trip.plan.get_plan().size());
+    EXPECT_GE(trip.tick_to_last_fill, std::chrono::microseconds(400));
+    EXPECT_GE(trip.tick_to_last_fill, trip.tick_to_first_fill);
+    EXPECT_LE(trip.route_latency, trip.tick_to_first_fill);
+    for (const ExecutionReport& report : trip.reports) 
+    {
+        EXPECT_LE(report.filled, report.requested + 1e-9);
+        if (report.exchange_name == "Exchange1") 
+        {
+            EXPECT_NEAR(report.filled, report.requested, 1e-9);
+        }
+        else 
+        {
+            EXPECT_GE(report.filled, 0.5 * report.requested - 1e-9);
+        }
+    }
+    EXPECT_LE(trip.filled, 1.0 + 1e-9);
+    EXPECT_GE(trip.filled, 0.75 - 1e-9);
+    // Fills never trade through the planned prices
+    EXPECT_LE(trip.slippage_bps, 1e-6);
+    EXPECT_NEAR(venues[0]->get_book().get_best_ask().first, exchange1->get_best_ask().first, 1e-9);
+}
+
+// Opposing parents cross at the mid without fees; only the net residual reaches the books
+TEST(SmartOrderRouterTest, NettingCrossesOpposingParents)
+{
+    auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.1);
+    auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.1);
+    for (int i = 0; i < 10; ++i) 
+    {
+        exchange1->add_ask(100.1 + 0.1 * i, 0.5);
+        exchange2->add_ask(100.15 + 0.1 * i, 0.5);
+        exchange1->add_bid(99.9 - 0.1 * i, 0.5);
+        exchange2->add_bid(99.85 - 0.1 * i, 0.5);
+    }
+    SmartOrderRouter router({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    Volume bids_before = router.get_liquidity_snapshots()[0].bids.volume + router.get_liquidity_snapshots()[1].bids.volume;
+
+    NettingResult result = net_and_route(router, {{1.0, OrderSide::BUY}, {0.6, OrderSide::SELL}, {0.5, OrderSide::BUY}});
+    EXPECT_DOUBLE_EQ(result.reference_mid, 100.0);
+    EXPECT_NEAR(result.crossed_volume, 0.6, 1e-9);
+    EXPECT_NEAR(result.residual_volume, 0.9, 1e-9);
+    EXPECT_EQ(result.routing_calls, 1u);
+    ASSERT_EQ(result.plans.size(), 3u);
+
+    const ExecutionPlan& seller = result.plans[1];
+    ASSERT_EQ(seller.get_plan().size(), 1u);
+    EXPECT_EQ(seller.get_plan()[0].exchange_name, INTERNAL_VENUE);
+    EXPECT_DOUBLE_EQ(seller.get_total(), 60.0);
+    EXPECT_DOUBLE_EQ(seller.get_total_fees(), 0.0);
+    EXPECT_NEAR(seller.get_fulfillment_percentage(), 100.0, 1e-9);
+    for (size_t i : {0u, 2u}) 
+    {
+        const ExecutionPlan& buyer = result.plans[i];
+        EXPECT_EQ(buyer.get_plan()[0].exchange_name, INTERNAL_VENUE);
+        EXPECT_NEAR(buyer.get_plan()[0].volume, buyer.get_original_order_size() * 0.4, 1e-9);
+        EXPECT_NEAR(buyer.get_fulfillment_percentage(), 100.0, 1e-6);
+        EXPECT_GT(buyer.get_average_effective_price(), 100.0);
+    }
+    Volume bids_after = router.get_liquidity_snapshots()[0].bids.volume + router.get_liquidity_snapshots()[1].bids.volume;
+    EXPECT_DOUBLE_EQ(bids_before, bids_after);
+
+    // Batches net each window; a one-sided window is routed order by order
+    std::istringstream input("1.0,BUY,H\n1.0,SELL,H\n0.3,BUY,G\n0.2,BUY,G\n");
+    std::ostringstream output;
+    BatchSummary summary = run_batch(router, input, output, BatchFormat::JSON_LINES, nullptr, 2);
+    EXPECT_EQ(summary.orders, 4u);
+    EXPECT_EQ(summary.routing_calls, 2u);
+    EXPECT_NEAR(summary.netted_volume, 1.0, 1e-9);
+    EXPECT_NE(output.str().find("\"exchange\":\"INTERNAL\""), std::string::npos);
+    std::ostringstream report;
+    print_batch_summary(summary, report);
+    EXPECT_NE(report.str().find("Routing latency (us, per netting window of 2 orders)"), std::string::npos);
+}
+
+// ADAPTIVE runs the optimizer while calibrating, then only when the learned benefit covers its latency
+TEST(SmartOrderRouterTest, AdaptiveHybridLearnsWhenToOptimize)
+{
+    auto make_router = []() 
+    {
+        auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.3);
+        auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0005, 0.2);
+        for (int i = 0; i < 50; ++i) 
+        {
+            exchange1->add_ask(100.0 + 0.01 * i, 0.7);
+            exchange2->add_ask(100.05 + 0.01 * i, 0.5);
+        }
+        return SmartOrderRouter({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    };
+
+    SmartOrderRouter router = make_router();
+    AdaptiveHybridConfig config;
+    config.warmup_runs = 3;
+    config.explore_interval = 1000;
+    config.latency_cost_per_us = 1e9;       // Nothing is worth its latency once calibrated
+    router.set_adaptive_config(config);
+    for (int i = 0; i < 10; ++i) 
+    {
+        ExecutionPlan adaptive = router.quote(1.1, OrderSide::BUY, RoutingAlgorithm::ADAPTIVE);
+        ExecutionPlan reference = (i < 3) ? router.quote(1.1, OrderSide::BUY, RoutingAlgorithm::HYBRID)
+                                          : router.quote(1.1, OrderSide::BUY, RoutingAlgorithm::PURE_GREEDY);
+        EXPECT_NEAR(adaptive.get_total(), reference.get_total(), 1e-9) << "quote " << i;
+    }
+    AdaptiveHybridStats stats = router.get_adaptive_stats();
+    EXPECT_EQ(stats.decisions, 10u);
+    EXPECT_EQ(stats.optimizer_runs, 3u);
+    EXPECT_EQ(stats.explorations, 3u);
+    EXPECT_EQ(stats.declined, 7u);
+    ASSERT_EQ(stats.buckets.size(), 1u);
+    EXPECT_EQ(stats.buckets[0].runs, 3u);
+    EXPECT_GT(stats.buckets[0].runtime_us, 0.0);
+
+    // Free latency: every switch is taken and the plans match HYBRID
+    config.latency_cost_per_us = 0.0;
+    router.set_adaptive_config(config);
+    ExecutionPlan adaptive = router.distribute_order(1.1, OrderSide::BUY, RoutingAlgorithm::ADAPTIVE);
+    SmartOrderRouter hybrid_router = make_router();
+    ExecutionPlan hybrid = hybrid_router.distribute_order(1.1, OrderSide::BUY, RoutingAlgorithm::HYBRID);
+    EXPECT_NEAR(adaptive.get_total(), hybrid.get_total(), 1e-9);
+    EXPECT_TRUE(adaptive.is_optimizer_used());
+    stats = router.get_adaptive_stats();
+    EXPECT_EQ(stats.optimizer_runs, 4u);
+    EXPECT_EQ(stats.explorations, 3u);
+    EXPECT_GE(stats.buckets[0].benefit_bps, 0.0);
+
+    router.clear_adaptive_model();
+    EXPECT_EQ(router.get_adaptive_stats().decisions, 0u);
+}
+
+// Coarsened searches fill the same volume and stay within the error bound they report
+TEST(SmartOrderRouterTest, OptimizerCoarseningReportsErrorBound)
+{
+    auto make_router = []() 
+    {
+        auto exchange1 = std::make_shared<OrderBook>("Exchange1", 0.001, 0.01);
+        auto exchange2 = std::make_shared<OrderBook>("Exchange2", 0.0002, 0.07);
+        for (int i = 0; i < 200; ++i) 
+        {
+            exchange1->add_ask(100.0 + 0.01 * i, 0.025);
+            exchange2->add_ask(100.06 + 0.013 * i, 0.08);
+        }
+        return SmartOrderRouter({{"Exchange1", exchange1}, {"Exchange2", exchange2}});
+    };
+    SmartOrderRouter exact_router = make_router();
+    SmartOrderRouter coarse_router = make_router();
+    coarse_router.set_optimizer_coarsening({10.0, 4});
+
+    for (Volume size : {0.35, 0.93, 1.77, 2.41}) 
+    {
+        ExecutionPlan exact = exact_router.quote(size, OrderSide::BUY);
+        ExecutionPlan coarse = coarse_router.quote(size, OrderSide::BUY);
+        ASSERT_TRUE(coarse.is_optimizer_used()) << size;
+        EXPECT_EQ(exact.get_coarsening_error_bound(), 0.0);
+        EXPECT_NEAR(coarse.get_fulfillment_percentage(), exact.get_fulfillment_percentage(), 1e-6) << size;
+        EXPECT_GE(coarse.get_total(), exact.get_total() - 1e-9) << size;
+        EXPECT_LE(coarse.get_total(), exact.get_total() + coarse.get_coarsening_error_bound() + 1e-9) << size;
+    }
+}
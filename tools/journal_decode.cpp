@@ -0,0 +1,46 @@
+#include "planjournal.h"
+#include <cstdio>
+#include <iostream>
+
+// Offline decoder for PlanJournal files: one CSV row per fill (plans without fills get one row with
+// empty fill columns), followed by a summary on stderr.
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) 
+    {
+        std::cerr << "Usage: " << argv[0] << " JOURNAL_FILE\n";
+        return 1;
+    }
+
+    JournalContents contents;
+    try 
+    {
+        contents = read_journal(argv[1]);
+    } 
+    catch (const std::exception& e) 
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::printf("sequence,timestamp_ns,side,requested,total,fees,optimizer,proven_optimal,optimality_gap,exchange,price,volume\n");
+    for (const JournalEntry& entry : contents.entries) 
+    {
+        char prefix[256];
+        std::snprintf(prefix, sizeof(prefix), "%llu,%lld,%s,%.8f,%.8f,%.8f,%d,%d,%.8f",
+                      static_cast<unsigned long long>(entry.sequence), static_cast<long long>(entry.timestamp_ns),
+                      entry.side == OrderSide::BUY ? "BUY" : "SELL", entry.requested, entry.total, entry.fees,
+                      (entry.flags & JOURNAL_OPTIMIZER_USED) ? 1 : 0, (entry.flags & JOURNAL_PROVEN_OPTIMAL) ? 1 : 0,
+                      entry.optimality_gap);
+        if (entry.fills.empty()) std::printf("%s,,,\n", prefix);
+        for (const FillOrder& fill : entry.fills) 
+        {
+            std::printf("%s,%s,%.8f,%.8f\n", prefix, fill.exchange_name.c_str(), fill.price, fill.volume);
+        }
+    }
+
+    std::cerr << "Plans: " << contents.header.plans << ", Dropped: " << contents.header.dropped
+              << ", Bytes used: " << contents.header.write_offset << " of " << contents.header.capacity << "\n";
+    return 0;
+}